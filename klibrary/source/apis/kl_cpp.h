@@ -5,8 +5,11 @@
 #include <array>
 #include <atomic>
 #include <bitset>
+#include <charconv>
+#include <condition_variable>
 #include <cstdint>
 #include <ctime>
+#include <deque>
 #include <execution>
 #include <filesystem>
 #include <format>
@@ -22,7 +25,9 @@
 #include <random>
 #include <ranges>
 #include <set>
+#include <shared_mutex>
 #include <source_location>
+#include <span>
 #include <sstream>
 #include <syncstream>
 #include <thread>
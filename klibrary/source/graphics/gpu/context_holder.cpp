@@ -157,6 +157,18 @@ void kl::ContextHolder::write_to_buffer(const dx::Buffer& gpu_buffer, const void
     m_context->Unmap(gpu_buffer.get(), 0);
 }
 
+void kl::ContextHolder::update_buffer(const dx::Buffer& gpu_buffer, const void* cpu_buffer, const UINT byte_offset, const UINT byte_size) const
+{
+    D3D11_BOX destination_box{};
+    destination_box.left = byte_offset;
+    destination_box.right = byte_offset + byte_size;
+    destination_box.top = 0;
+    destination_box.bottom = 1;
+    destination_box.front = 0;
+    destination_box.back = 1;
+    m_context->UpdateSubresource(gpu_buffer.get(), 0, &destination_box, cpu_buffer, 0, 0);
+}
+
 void kl::ContextHolder::read_from_texture(void* cpu_buffer, const dx::Texture& gpu_buffer, const Int2 cpu_size, const UINT element_size) const
 {
     dx::MappedSubresourceDescriptor mapped_subresource{};
@@ -41,6 +41,7 @@ namespace kl {
 
         void read_from_buffer(void* cpu_buffer, const dx::Buffer& gpu_buffer, SIZE_T byte_size) const;
         void write_to_buffer(const dx::Buffer& gpu_buffer, const void* cpu_buffer, SIZE_T byte_size, bool discard = true) const;
+        void update_buffer(const dx::Buffer& gpu_buffer, const void* cpu_buffer, UINT byte_offset, UINT byte_size) const;
 
         void read_from_texture(void* cpu_buffer, const dx::Texture& gpu_buffer, Int2 cpu_size, UINT element_size) const;
         void write_to_texture(const dx::Texture& gpu_buffer, const void* cpu_buffer, Int2 cpu_size, UINT element_size, bool discard = true) const;
@@ -4,9 +4,9 @@
 kl::File::File()
 {}
 
-kl::File::File(const std::string_view& filepath, const bool write)
+kl::File::File(const std::string_view& filepath, const bool write, const bool truncate)
 {
-    open(filepath, write);
+    open(filepath, write, truncate);
 }
 
 kl::File::~File()
@@ -19,10 +19,17 @@ kl::File::operator bool() const
     return (bool) m_file;
 }
 
-void kl::File::open(const std::string_view& filepath, const bool write)
+void kl::File::open(const std::string_view& filepath, const bool write, const bool truncate)
 {
     close();
-    fopen_s(&m_file, filepath.data(), write ? "wb" : "rb");
+    if (write && !truncate) {
+        m_file = _fsopen(filepath.data(), "r+b", _SH_DENYNO);
+        if (!m_file) {
+            m_file = _fsopen(filepath.data(), "w+b", _SH_DENYNO);
+        }
+        return;
+    }
+    m_file = _fsopen(filepath.data(), write ? "wb" : "rb", _SH_DENYNO);
 }
 
 void kl::File::close()
@@ -70,6 +77,14 @@ int64_t kl::File::tell() const
     return ftell(m_file);
 }
 
+bool kl::File::flush()
+{
+    if (!m_file) {
+        return false;
+    }
+    return !fflush(m_file);
+}
+
 std::string kl::file_extension(const std::string_view& filepath)
 {
     return std::filesystem::path(filepath).extension().string();
@@ -7,12 +7,12 @@ namespace kl {
     struct File : NoCopy
     {
         File();
-        File(const std::string_view& filepath, bool write);
+        File(const std::string_view& filepath, bool write, bool truncate = true);
         ~File();
 
         operator bool() const;
 
-        void open(const std::string_view& filepath, bool write);
+        void open(const std::string_view& filepath, bool write, bool truncate = true);
         void close();
 
         bool seek(int64_t position) const;
@@ -22,6 +22,7 @@ namespace kl {
         bool unwind() const;
 
         int64_t tell() const;
+        bool flush();
 
         template<typename T>
         T read() const
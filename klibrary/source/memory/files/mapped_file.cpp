@@ -0,0 +1,96 @@
+#include "klibrary.h"
+
+
+kl::MappedFile::MappedFile()
+{}
+
+kl::MappedFile::MappedFile(const std::string_view& filepath)
+{
+    open(filepath);
+}
+
+kl::MappedFile::~MappedFile()
+{
+    close();
+}
+
+kl::MappedFile::operator bool() const
+{
+    return (bool) m_data;
+}
+
+void kl::MappedFile::open(const std::string_view& filepath)
+{
+    close();
+
+    m_file = CreateFileA(filepath.data(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    LARGE_INTEGER file_size = {};
+    if (!GetFileSizeEx(m_file, &file_size) || file_size.QuadPart <= 0) {
+        close();
+        return;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping) {
+        close();
+        return;
+    }
+
+    m_data = (const byte*) MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!m_data) {
+        close();
+        return;
+    }
+    m_size = (uint64_t) file_size.QuadPart;
+}
+
+void kl::MappedFile::close()
+{
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+    m_size = 0;
+}
+
+uint64_t kl::MappedFile::size() const
+{
+    return m_size;
+}
+
+const byte* kl::MappedFile::data() const
+{
+    return m_data;
+}
+
+std::span<const byte> kl::MappedFile::view(const uint64_t offset, const uint64_t size) const
+{
+    if (!m_data || offset >= m_size) {
+        return {};
+    }
+    return { m_data + offset, (size_t) min(size, m_size - offset) };
+}
+
+bool kl::MappedFile::prefetch(const uint64_t offset, const uint64_t size) const
+{
+    const std::span<const byte> range = view(offset, size);
+    if (range.empty()) {
+        return false;
+    }
+    WIN32_MEMORY_RANGE_ENTRY entry = {};
+    entry.VirtualAddress = (PVOID) range.data();
+    entry.NumberOfBytes = range.size();
+    return PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "apis/apis.h"
+
+
+namespace kl {
+    struct MappedFile : NoCopy
+    {
+        MappedFile();
+        MappedFile(const std::string_view& filepath);
+        ~MappedFile();
+
+        operator bool() const;
+
+        void open(const std::string_view& filepath);
+        void close();
+
+        uint64_t size() const;
+        const byte* data() const;
+
+        std::span<const byte> view(uint64_t offset, uint64_t size) const;
+        bool prefetch(uint64_t offset, uint64_t size) const;
+
+    private:
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+        const byte* m_data = nullptr;
+        uint64_t m_size = 0;
+    };
+}
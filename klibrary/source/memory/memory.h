@@ -3,6 +3,7 @@
 #include "memory/safety/ref.h"
 #include "memory/safety/com_ref.h"
 #include "memory/files/file.h"
+#include "memory/files/mapped_file.h"
 #include "memory/files/dll.h"
 
 
@@ -6,5 +6,6 @@
 #include "render/light/ambient_light.h"
 #include "render/light/directional_light.h"
 #include "render/scene/entity.h"
+#include "render/scene/entity_storage.h"
 #include "render/scene/camera.h"
 #include "render/scene/scene.h"
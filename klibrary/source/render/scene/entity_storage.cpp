@@ -0,0 +1,184 @@
+#include "klibrary.h"
+
+
+static void integrate(float* position, float* velocity, const float* acceleration, const float bias, const float delta_t, const size_t first, const size_t last)
+{
+#pragma loop(ivdep)
+    for (size_t i = first; i < last; i++) {
+        velocity[i] += (acceleration[i] + bias) * delta_t;
+        position[i] += velocity[i] * delta_t;
+    }
+}
+
+static void integrate(float* rotation, const float* angular, const float delta_t, const size_t first, const size_t last)
+{
+#pragma loop(ivdep)
+    for (size_t i = first; i < last; i++) {
+        rotation[i] += angular[i] * delta_t;
+    }
+}
+
+void kl::Float3Array::resize(const size_t size, const Float3& value)
+{
+    x.resize(size, value.x);
+    y.resize(size, value.y);
+    z.resize(size, value.z);
+}
+
+void kl::Float3Array::set(const size_t index, const Float3& value)
+{
+    x[index] = value.x;
+    y[index] = value.y;
+    z[index] = value.z;
+}
+
+kl::Float3 kl::Float3Array::get(const size_t index) const
+{
+    return { x[index], y[index], z[index] };
+}
+
+void kl::Float3Array::swap_remove(const size_t index)
+{
+    for (auto* values : { &x, &y, &z }) {
+        (*values)[index] = values->back();
+        values->pop_back();
+    }
+}
+
+size_t kl::EntityStorage::size() const
+{
+    return position.x.size();
+}
+
+void kl::EntityStorage::resize(const size_t size)
+{
+    scale.resize(size, Float3{ 1.0f });
+    rotation.resize(size);
+    position.resize(size);
+    acceleration.resize(size);
+    velocity.resize(size);
+    angular.resize(size);
+    meshes.resize(size);
+    materials.resize(size);
+}
+
+void kl::EntityStorage::clear()
+{
+    resize(0);
+}
+
+size_t kl::EntityStorage::add(const Entity& entity)
+{
+    const size_t index = size();
+    resize(index + 1);
+    set_entity(index, entity);
+    return index;
+}
+
+void kl::EntityStorage::remove(const size_t index)
+{
+    for (auto* array : { &scale, &rotation, &position, &acceleration, &velocity, &angular }) {
+        array->swap_remove(index);
+    }
+    meshes[index] = meshes.back();
+    meshes.pop_back();
+    materials[index] = materials.back();
+    materials.pop_back();
+}
+
+kl::Entity kl::EntityStorage::get_entity(const size_t index) const
+{
+    Entity result;
+    result.scale = scale.get(index);
+    result.rotation = rotation.get(index);
+    result.position = position.get(index);
+    result.acceleration = acceleration.get(index);
+    result.velocity = velocity.get(index);
+    result.angular = angular.get(index);
+    result.mesh = meshes[index];
+    result.material = materials[index];
+    return result;
+}
+
+void kl::EntityStorage::set_entity(const size_t index, const Entity& entity)
+{
+    scale.set(index, entity.scale);
+    rotation.set(index, entity.rotation);
+    position.set(index, entity.position);
+    acceleration.set(index, entity.acceleration);
+    velocity.set(index, entity.velocity);
+    angular.set(index, entity.angular);
+    meshes[index] = entity.mesh;
+    materials[index] = entity.material;
+}
+
+void kl::EntityStorage::update_physics(const Float3& gravity, const float delta_t)
+{
+    const int range_count = (int) ((size() + RANGE_SIZE - 1) / RANGE_SIZE);
+    if (range_count <= 1) {
+        update_range(gravity, delta_t, 0, size());
+        return;
+    }
+    kl::async_for(0, range_count, [&](const int range)
+    {
+        const size_t first = range * RANGE_SIZE;
+        update_range(gravity, delta_t, first, std::min(first + RANGE_SIZE, size()));
+    });
+}
+
+void kl::EntityStorage::update_range(const Float3& gravity, const float delta_t, const size_t first, const size_t last)
+{
+    integrate(position.x.data(), velocity.x.data(), acceleration.x.data(), gravity.x, delta_t, first, last);
+    integrate(position.y.data(), velocity.y.data(), acceleration.y.data(), gravity.y, delta_t, first, last);
+    integrate(position.z.data(), velocity.z.data(), acceleration.z.data(), gravity.z, delta_t, first, last);
+
+    integrate(rotation.x.data(), angular.x.data(), delta_t, first, last);
+    integrate(rotation.y.data(), angular.y.data(), delta_t, first, last);
+    integrate(rotation.z.data(), angular.z.data(), delta_t, first, last);
+}
+
+kl::EntityBenchmark kl::benchmark_entities(const int entity_count, const int step_count)
+{
+    EntityBenchmark result;
+    result.entity_count = entity_count;
+    result.step_count = step_count;
+
+    Scene legacy;
+    Scene storage;
+    legacy.entities.reserve(entity_count);
+    for (int i = 0; i < entity_count; i++) {
+        Ref<Entity> entity = new Entity();
+        entity->position = { random::gen_float(-256.0f, 256.0f), random::gen_float(0.0f, 64.0f), random::gen_float(-256.0f, 256.0f) };
+        entity->velocity = { random::gen_float(-4.0f, 4.0f), random::gen_float(0.0f, 8.0f), random::gen_float(-4.0f, 4.0f) };
+        entity->angular = { 0.0f, random::gen_float(-90.0f, 90.0f), 0.0f };
+        storage.bodies.add(*entity);
+        legacy.entities.push_back(entity);
+    }
+
+    static constexpr float delta_t = 1.0f / 60.0f;
+    uint64_t start_time = time::now();
+    for (int i = 0; i < step_count; i++) {
+        legacy.update_physics(delta_t);
+    }
+    const float legacy_time = time::elapsed(start_time);
+
+    start_time = time::now();
+    for (int i = 0; i < step_count; i++) {
+        storage.update_physics(delta_t);
+    }
+    const float storage_time = time::elapsed(start_time);
+
+    for (int i = 0; i < entity_count; i++) {
+        const float error = (legacy.entities[i]->position - storage.bodies.position.get(i)).length();
+        result.max_error = max(result.max_error, error);
+    }
+
+    const float updates = float(entity_count) * step_count;
+    if (legacy_time > 0.0f) {
+        result.legacy_rate = updates / (legacy_time * 1000.0f);
+    }
+    if (storage_time > 0.0f) {
+        result.storage_rate = updates / (storage_time * 1000.0f);
+    }
+    return result;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "render/scene/entity.h"
+
+
+namespace kl {
+    struct EntityBenchmark
+    {
+        int entity_count = 0;
+        int step_count = 0;
+        float legacy_rate = 0.0f;
+        float storage_rate = 0.0f;
+        float max_error = 0.0f;
+    };
+
+    struct Float3Array
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+
+        void resize(size_t size, const Float3& value = {});
+        void set(size_t index, const Float3& value);
+        Float3 get(size_t index) const;
+        void swap_remove(size_t index);
+    };
+
+    struct EntityStorage
+    {
+        static constexpr size_t RANGE_SIZE = 4096;
+
+        Float3Array scale;
+        Float3Array rotation;
+        Float3Array position;
+
+        Float3Array acceleration;
+        Float3Array velocity;
+        Float3Array angular;
+
+        std::vector<Ref<Mesh>> meshes;
+        std::vector<Ref<Material>> materials;
+
+        size_t size() const;
+        void resize(size_t size);
+        void clear();
+
+        size_t add(const Entity& entity);
+        void remove(size_t index);
+
+        // Entities are stored as separate arrays, so this returns a copy; write changes back with set_entity
+        Entity get_entity(size_t index) const;
+        void set_entity(size_t index, const Entity& entity);
+
+        void update_physics(const Float3& gravity, float delta_t);
+        void update_range(const Float3& gravity, float delta_t, size_t first, size_t last);
+    };
+
+    EntityBenchmark benchmark_entities(int entity_count, int step_count);
+}
@@ -9,4 +9,5 @@ void kl::Scene::update_physics(const float delta_t)
         entity->position += entity->velocity * delta_t;
         entity->rotation += entity->angular * delta_t;
     }
+    bodies.update_physics(gravity, delta_t);
 }
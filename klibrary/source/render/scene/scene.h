@@ -2,6 +2,7 @@
 
 #include "render/scene/camera.h"
 #include "render/scene/entity.h"
+#include "render/scene/entity_storage.h"
 #include "render/light/ambient_light.h"
 #include "render/light/directional_light.h"
 
@@ -10,6 +11,7 @@ namespace kl {
     struct Scene
     {
         std::vector<Ref<Entity>> entities;
+        EntityStorage bodies;
 
         Ref<Camera> main_camera = nullptr;
         Ref<AmbientLight> main_ambient_light = nullptr;
@@ -3,6 +3,7 @@ struct VS_OUT
     float3 world : VS_World;
     float4 position : SV_Position;
     float2 textur : VS_Texture;
+    nointerpolation float2 atlas : VS_Atlas;
     float ambient : VS_Ambient;
     float4 sun : VS_Sun;
 };
@@ -15,6 +16,8 @@ static const float2 DEFINED_TEXTURES[4] = {
     { 1.0f, 1.0f },
 };
 static const float AMBIENT_FACTOR = 0.2f;
+static const float PETTLE_NEAR = 0.14644661f;
+static const float PETTLE_FAR = 1.0f - PETTLE_NEAR;
 
 float4x4 VP;
 float4x4 SUN_VP;
@@ -23,6 +26,7 @@ float ELAPSED_TIME;
 float3 SUN_DIRECTION;
 float RENDER_DISTANCE;
 float2 SHADOW_TEXEL_SIZE;
+float2 CHUNK_ORIGIN;
 
 Texture2D SHADOW_TEXTURE : register(t0);
 Texture2D ATLAS_TEXTURE : register(t1);
@@ -35,9 +39,30 @@ int2 atlas_pos(uint block)
     return int2((block >> 4) & 0xF, block & 0xF);
 }
 
-float2 atlas_uv(uint block, uint textur)
+float2 tiled_uv(uint textur, uint tiling)
 {
-    return (DEFINED_TEXTURES[textur] + atlas_pos(block)) * (1.0f / 16.0f);
+    float2 tiles = float2((tiling & 0xF) + 1, ((tiling >> 4) & 0xF) + 1);
+    return DEFINED_TEXTURES[textur] * tiles;
+}
+
+float2 atlas_uv(float2 atlas, float2 uv)
+{
+    return (atlas + frac(uv)) * (1.0f / 16.0f);
+}
+
+float3 unpack_position(uint geometry)
+{
+    float3 position = float3(geometry & 0x1F, (geometry >> 5) & 0x7F, (geometry >> 12) & 0x1F);
+    uint face = (geometry >> 17) & 0x7;
+    if (face >= 6)
+    {
+        uint textur = (geometry >> 20) & 0x3;
+        float x = (textur >= 2) ? PETTLE_FAR : PETTLE_NEAR;
+        float y = (textur == 1 || textur == 2) ? 1.0f : 0.0f;
+        float z = (face == 6) ? x : 1.0f - x;
+        position += float3(x, y, z);
+    }
+    return position + float3(CHUNK_ORIGIN.x, 0.0f, CHUNK_ORIGIN.y);
 }
 
 float get_pcf_shadow(float3 light_coords, int half_kernel_size)
@@ -58,12 +83,13 @@ float get_pcf_shadow(float3 light_coords, int half_kernel_size)
     return shadow_factor / ((half_kernel_size * 2 + 1) * (half_kernel_size * 2 + 1));
 }
 
-VS_OUT v_shader(float3 position : KL_Position, uint textur : KL_Texture, uint ambient : KL_Ambient, uint block : KL_Block)
+VS_OUT process_vertex(float3 position, uint textur, uint ambient, uint block, uint tiling)
 {
     VS_OUT data;
     data.world = position;
     data.position = mul(float4(data.world, 1.0f), VP);
-    data.textur = atlas_uv(block, textur);
+    data.textur = tiled_uv(textur, tiling);
+    data.atlas = atlas_pos(block);
     data.ambient = ambient * (AMBIENT_FACTOR / 255.0f);
     
     data.sun = mul(float4(position, 1.0f), SUN_VP);
@@ -73,9 +99,21 @@ VS_OUT v_shader(float3 position : KL_Position, uint textur : KL_Texture, uint am
     return data;
 }
 
+#ifdef PACKED_VERTICES
+VS_OUT v_shader(uint2 packed : KL_Packed)
+{
+    return process_vertex(unpack_position(packed.x), (packed.x >> 20) & 0x3, packed.y & 0xFF, (packed.y >> 8) & 0xFF, (packed.x >> 22) & 0xFF);
+}
+#else
+VS_OUT v_shader(float3 position : KL_Position, uint textur : KL_Texture, uint ambient : KL_Ambient, uint block : KL_Block, uint tiling : KL_Tiling)
+{
+    return process_vertex(position, textur, ambient, block, tiling);
+}
+#endif
+
 float4 p_shader(VS_OUT data) : SV_Target0
 {
-    float4 color = ATLAS_TEXTURE.Sample(ATLAS_SAMPLER, data.textur);
+    float4 color = ATLAS_TEXTURE.Sample(ATLAS_SAMPLER, atlas_uv(data.atlas, data.textur));
     if (color.a < 1.0f)
         discard;
     
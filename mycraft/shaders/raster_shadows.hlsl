@@ -2,6 +2,7 @@ struct VS_OUT
 {
     float4 position : SV_Position;
     float2 textur : VS_Texture;
+    nointerpolation float2 atlas : VS_Atlas;
 };
 
 static const float PI = 3.1415926535897932384626433832795f;
@@ -12,11 +13,14 @@ static const float2 DEFINED_TEXTURES[4] =
 	{ 1.0f, 0.0f },
 	{ 1.0f, 1.0f },
 };
+static const float PETTLE_NEAR = 0.14644661f;
+static const float PETTLE_FAR = 1.0f - PETTLE_NEAR;
 
 float4x4 VP;
 float3 CAMERA_ORIGIN;
 float ELAPSED_TIME;
 float RENDER_DISTANCE;
+float2 CHUNK_ORIGIN;
 
 Texture2D ATLAS_TEXTURE : register(t0);
 
@@ -27,22 +31,56 @@ int2 atlas_pos(uint block)
     return int2((block >> 4) & 0xF, block & 0xF);
 }
 
-float2 atlas_uv(uint block, uint textur)
+float2 tiled_uv(uint textur, uint tiling)
 {
-    return (DEFINED_TEXTURES[textur] + atlas_pos(block)) * (1.0f / 16.0f);
+    float2 tiles = float2((tiling & 0xF) + 1, ((tiling >> 4) & 0xF) + 1);
+    return DEFINED_TEXTURES[textur] * tiles;
 }
 
-VS_OUT v_shader(float3 position : KL_Position, uint textur : KL_Texture, uint block : KL_Block)
+float2 atlas_uv(float2 atlas, float2 uv)
+{
+    return (atlas + frac(uv)) * (1.0f / 16.0f);
+}
+
+float3 unpack_position(uint geometry)
+{
+    float3 position = float3(geometry & 0x1F, (geometry >> 5) & 0x7F, (geometry >> 12) & 0x1F);
+    uint face = (geometry >> 17) & 0x7;
+    if (face >= 6)
+    {
+        uint textur = (geometry >> 20) & 0x3;
+        float x = (textur >= 2) ? PETTLE_FAR : PETTLE_NEAR;
+        float y = (textur == 1 || textur == 2) ? 1.0f : 0.0f;
+        float z = (face == 6) ? x : 1.0f - x;
+        position += float3(x, y, z);
+    }
+    return position + float3(CHUNK_ORIGIN.x, 0.0f, CHUNK_ORIGIN.y);
+}
+
+VS_OUT process_vertex(float3 position, uint textur, uint block, uint tiling)
 {
     VS_OUT data;
     data.position = mul(float4(position, 1.0f), VP);
-    data.textur = atlas_uv(block, textur);
+    data.textur = tiled_uv(textur, tiling);
+    data.atlas = atlas_pos(block);
     return data;
 }
 
+#ifdef PACKED_VERTICES
+VS_OUT v_shader(uint2 packed : KL_Packed)
+{
+    return process_vertex(unpack_position(packed.x), (packed.x >> 20) & 0x3, (packed.y >> 8) & 0xFF, (packed.x >> 22) & 0xFF);
+}
+#else
+VS_OUT v_shader(float3 position : KL_Position, uint textur : KL_Texture, uint block : KL_Block, uint tiling : KL_Tiling)
+{
+    return process_vertex(position, textur, block, tiling);
+}
+#endif
+
 void p_shader(VS_OUT data)
 {
-    float alpha = ATLAS_TEXTURE.Sample(ATLAS_SAMPLER, data.textur).a;
+    float alpha = ATLAS_TEXTURE.Sample(ATLAS_SAMPLER, atlas_uv(data.atlas, data.textur)).a;
     if (alpha < 1.0f)
         discard;
 }
@@ -80,6 +80,8 @@ float4x4 INV_CAM;
 float3 CAMERA_POSITION;
 float RENDER_DISTANCE;
 float3 SUN_DIRECTION;
+float WIDTH_CHUNKS;
+float2 FIRST_CHUNK;
 
 Buffer<uint> BLOCKS_TEXTURE : register(t0);
 Texture2D<float4> ATLAS_TEXTURE : register(t1);
@@ -98,21 +100,21 @@ float3 to_chunk_pos(float3 pos)
 
 bool in_world_bounds(float3 pos)
 {
-    float3 bottom_left = to_chunk_pos(CAMERA_POSITION - RENDER_DISTANCE * CHUNK_SIZE);
-    float3 top_right = to_chunk_pos(CAMERA_POSITION + RENDER_DISTANCE * CHUNK_SIZE) + CHUNK_SIZE;
+    float3 bottom_left = float3(FIRST_CHUNK.x, 0.0f, FIRST_CHUNK.y);
+    float3 top_right = bottom_left + float3(WIDTH_CHUNKS, 1.0f, WIDTH_CHUNKS) * CHUNK_SIZE;
     return all(pos >= bottom_left && pos <= top_right);
 }
 
 uint get_block(float3 pos)
 {
     static const int chunk_blocks = CHUNK_WIDTH * CHUNK_WIDTH * CHUNK_HEIGHT;
-    const int width_chunks = RENDER_DISTANCE * 2 + 1;
+    const int width_chunks = WIDTH_CHUNKS;
     
-    int3 first_chunk = to_chunk_pos(CAMERA_POSITION - RENDER_DISTANCE * CHUNK_SIZE);
-    int3 chunk_ind = to_chunk_pos(pos - first_chunk) / CHUNK_SIZE;    
+    int3 chunk_ind = to_chunk_pos(pos) / CHUNK_SIZE;
+    int2 ring_ind = ((chunk_ind.xz % width_chunks) + width_chunks) % width_chunks;
     int3 block_ind = floor(pos - to_chunk_pos(pos));    
     
-    int ind = (chunk_ind.x + chunk_ind.z * width_chunks) * chunk_blocks
+    int ind = (ring_ind.x + ring_ind.y * width_chunks) * chunk_blocks
         + (block_ind.x + (block_ind.z * CHUNK_WIDTH) + (block_ind.y * CHUNK_WIDTH * CHUNK_WIDTH));
     return BLOCKS_TEXTURE[ind];
 }
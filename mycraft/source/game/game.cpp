@@ -20,6 +20,12 @@ void Player::set_position( flt3 const& position )
     camera.position = position + flt3{ 0.0f, PLAYER_HEIGHT, 0.0f };
 }
 
+void Player::sync_body()
+{
+    body_position = position();
+    previous_body_position = body_position;
+}
+
 Game::Game( World& world )
     : world( world )
     , environment( world.system.gpu )
@@ -28,6 +34,9 @@ Game::Game( World& world )
     window.mouse.set_position( window.frame_center() );
     player.camera.position = { 5.0f, 5.0f, 5.0f };
     player.camera.set_forward( { 1.0f, -1.0f, 1.0f } );
+    player.sync_body();
+    physics.step = PHYSICS_STEP;
+    physics.max_substeps = MAX_PHYSICS_STEPS;
 
     int counter = 0;
     for ( auto value : { Block::GRASS, Block::DIRT, Block::STONE, Block::COBBLE, Block::WOOD, Block::PLANKS, Block::COBWEB, Block::ROSE, Block::DANDELION } )
@@ -45,12 +54,13 @@ void Game::update()
     if ( player.gamemode == GameMode::CREATIVE )
     {
         update_creative_movement( delta_t );
+        player.sync_body();
+        physics.reset();
     }
     else
     {
-        update_survival_movement( delta_t );
-        update_velocity( delta_t );
-        update_collisions( delta_t );
+        update_survival_movement();
+        update_physics( delta_t );
     }
     update_time();
     update_world();
@@ -91,10 +101,10 @@ void Game::handle_mouse_input()
             return;
 
         auto& payload = opt_payload.value();
-        auto& chunk = world.get_chunk( payload.chunk_ind );
-        chunk.remove_block( payload.block_ind );
-        world.upload_tracing();
-        world.upload_save( payload.chunk_ind );
+        if ( !world.chunk_ready( payload.chunk_ind ) )
+            return;
+
+        world.edit_block( payload.chunk_ind, payload.block_ind, Block::AIR );
     }
     if ( window.mouse.middle.pressed() )
     {
@@ -104,7 +114,7 @@ void Game::handle_mouse_input()
 
         auto& payload = opt_payload.value();
         auto& chunk = world.get_chunk( payload.chunk_ind );
-        if ( Block* block = chunk.get_block( payload.block_ind ) )
+        if ( std::optional<Block> block = chunk.get_block( payload.block_ind ) )
         {
             for ( int i = 0; i < Inventory::HORIZONTAL_COUNT; i++ )
             {
@@ -124,11 +134,10 @@ void Game::handle_mouse_input()
 
         auto& payload = opt_payload.value();
         world.adjust_by_normal( payload );
+        if ( !world.chunk_ready( payload.chunk_ind ) )
+            return;
 
-        auto& chunk = world.get_chunk( payload.chunk_ind );
-        chunk.place_block( payload.block_ind, player.inventory.selected_item().value_or( Block::AIR ) );
-        world.upload_tracing();
-        world.upload_save( payload.chunk_ind );
+        world.edit_block( payload.chunk_ind, payload.block_ind, player.inventory.selected_item().value_or( Block::AIR ) );
     }
 }
 
@@ -159,6 +168,105 @@ void Game::handle_keyboard_input()
     {
         render_mode = render_mode == RenderMode::RASTER ? RenderMode::TRACING : RenderMode::RASTER;
     }
+    if ( window.keyboard.multiply.pressed() )
+    {
+        world.set_mesh_mode( MeshMode( (world.mesh_mode() + 1) % MESH_MODE_COUNT ) );
+    }
+    if ( window.keyboard.backslash.pressed() )
+    {
+        world.set_vertex_format( world.vertex_format() == VertexFormat::PACKED ? VertexFormat::FULL : VertexFormat::PACKED );
+    }
+    if ( window.keyboard.f1.pressed() )
+    {
+        for ( float edit_ratio : { 0.0f, 0.05f } )
+        {
+            CodecBenchmark bench = world.benchmark_codec( edit_ratio, 4 );
+            kl::print( "Codec [edits ", edit_ratio * 100.0f, "%] ", bench.chunk_count, " chunks, ", bench.bytes_per_chunk, " bytes/chunk, encode ", bench.encode_throughput, " MB/s, decode ", bench.decode_throughput, " MB/s" );
+        }
+        LoadBenchmark load = benchmark_world_load( ChunkGenerator::WORLD_PATH + "load_bench/", 1024 );
+        kl::print( "Load [", load.chunk_count, " chunks] serial ", load.serial_rate, " chunks/ms, parallel ", load.parallel_rate, " chunks/ms, ", load.failed, " failed" );
+    }
+    if ( window.keyboard.f2.pressed() )
+    {
+        SaveStats stats = world.saver.stats();
+        kl::print( "Saves ", stats.pending, " pending, ", stats.written, " written, ", stats.coalesced, " coalesced, ", stats.failed, " failed, flush ", stats.flush_latency * 1000.0f, " ms (max ", stats.max_flush_latency * 1000.0f, " ms), write ", stats.write_latency * 1000.0f, " ms" );
+        kl::print( "Journal ", stats.journaled, " records, ", stats.checkpoints, " checkpoints, ", stats.replayed, " replayed" );
+        auto& generator = world.generator;
+        kl::print( "Storage ", generator.storage.used_bytes() / 1024, " KB, ", generator.delta_saves.load(), " delta, ", generator.snapshot_saves.load(), " snapshot, ", generator.baseline_saves.load(), " baseline saves" );
+    }
+    if ( window.keyboard.f3.pressed() )
+    {
+        JournalBenchmark bench = benchmark_journal( ChunkGenerator::WORLD_PATH + "journal_bench.wal", 10000 );
+        kl::print( "Journal [", bench.edit_count, " edits] ", bench.append_time * 1000000.0f, " us/edit, ", bench.edits_per_ms, " edits/ms, checkpoint ", bench.checkpoint_time * 1000.0f, " ms" );
+    }
+    if ( window.keyboard.f4.pressed() )
+    {
+        CacheStats stats = world.cache.stats();
+        kl::print( "Cache ", stats.resident_chunks, " chunks, ", stats.resident_bytes / 1024, "/", stats.budget_bytes / 1024, " KB, ", stats.hits, " hits, ", stats.misses, " misses (", stats.hit_ratio * 100.0f, "%), ", stats.evictions, " evictions" );
+        StreamStats stream = world.streamer.stats();
+        kl::print( "Streaming ", stream.queued, " queued, ", stream.in_flight, " in flight, ", stream.completed, " completed, ", stream.integrated, " integrated, ", stream.discarded, " discarded, ", stream.cancelled, " cancelled" );
+        kl::print( "Streaming latency queue ", stream.queue_latency * 1000.0f, " ms, generate ", stream.generate_latency * 1000.0f, " ms, mesh ", stream.mesh_latency * 1000.0f, " ms, integrate ", stream.integrate_latency * 1000.0f, " ms, first playable ", world.first_playable_time() * 1000.0f, " ms" );
+    }
+    if ( window.keyboard.f5.pressed() )
+    {
+        EditStats stats = world.edit_stats();
+        kl::print( "Edits ", stats.edits, ", remeshed ", stats.remeshed_chunks, " chunks / ", stats.remeshed_sections, " sections, latency ", stats.last_latency * 1000.0f, " ms (avg ", stats.average_latency * 1000.0f, " ms, max ", stats.max_latency * 1000.0f, " ms)" );
+    }
+    if ( window.keyboard.f6.pressed() )
+    {
+        static constexpr char const* mode_names[MESH_MODE_COUNT] = { "per-face", "greedy", "binary" };
+        MeshBenchmark bench = world.benchmark_meshing( 4 );
+        kl::print( "Meshing [", bench.chunk_count, " chunks] per-block test ", bench.test_time * 1000.0f, " ms/chunk, snapshot per-face ", bench.snapshot_time * 1000.0f, " ms/chunk, snapshot ", mode_names[world.mesh_mode()], " ", bench.mode_time * 1000.0f, " ms/chunk, ", bench.mismatches, " mismatched" );
+    }
+    if ( window.keyboard.f7.pressed() )
+    {
+        static constexpr char const* terrain_names[SYNTHETIC_TERRAIN_COUNT] = { "flat", "noisy", "caves" };
+        static constexpr char const* backend_names[VISIBILITY_BACKEND_COUNT] = { "scalar", "sse2", "avx2" };
+        for ( auto& bench : benchmark_visibility( 16, 8 ) )
+            kl::print( "Visibility [", terrain_names[bench.terrain], ", ", backend_names[bench.backend], "] kernel ", bench.kernel_rate, " chunks/s, binary mesh ", bench.mesh_rate, " chunks/s (", bench.core_rate, " chunks/s on one core)" );
+    }
+    if ( window.keyboard.f8.pressed() )
+    {
+        for ( float reach : { 5.0f, 64.0f } )
+        {
+            RayBenchmark bench = world.benchmark_ray_cast( 500, reach );
+            kl::print( "Rays [reach ", reach, "] ", bench.ray_count, " rays, ", bench.hits, " hits, dda ", bench.dda_time * 1000000.0f, " us/ray, brute force ", bench.brute_force_time * 1000000.0f, " us/ray, ", bench.mismatches, " mismatches" );
+        }
+    }
+    if ( window.keyboard.f9.pressed() )
+    {
+        for ( int batch_size : { 64, 1024, 16384 } )
+        {
+            RayBatchBenchmark bench = world.benchmark_ray_batch( batch_size, 8 );
+            kl::print( "Ray batch [", bench.batch_size, "] ", bench.batch_rate / 1000000.0f, " Mrays/s batched, ", bench.single_rate / 1000000.0f, " Mrays/s single, ", bench.mismatches, " mismatches" );
+        }
+    }
+    if ( window.keyboard.f10.pressed() )
+    {
+        StepperStats stats = physics.stats();
+        kl::print( "Physics ", stats.steps, " steps over ", stats.frames, " frames, ", stats.capped_frames, " capped, ", stats.dropped_time, " s dropped" );
+    }
+    if ( window.keyboard.f12.pressed() )
+    {
+        for ( int entity_count : { 1000, 50000 } )
+        {
+            kl::EntityBenchmark bench = kl::benchmark_entities( entity_count, 60 );
+            kl::print( "Entities [", bench.entity_count, "] legacy ", bench.legacy_rate, " entities/ms, storage ", bench.storage_rate, " entities/ms, max error ", bench.max_error );
+        }
+    }
+    if ( window.keyboard.insert.pressed() )
+    {
+        PackCheck pack = check_packing();
+        kl::print( "Check [packing] ", pack.quad_count, " quads, ", pack.mismatches, " mismatches, ", sizeof( Quad ), " bytes/quad full, ", sizeof( PackedQuad ) + 6 * sizeof( uint32_t ), " bytes/quad packed" );
+        AmbientCheck ambient = check_ambient();
+        kl::print( "Check [ambient] ", ambient.corner_cases, " corners, ", ambient.corner_mismatches, " mismatches, ", ambient.flip_cases, " flips, ", ambient.flip_mismatches, " mismatches" );
+        RayCheck rays = world.check_ray_cast();
+        kl::print( "Check [rays] ", rays.ray_count, " rays, ", rays.hits, " hits, ", rays.position_mismatches, " position mismatches, ", rays.normal_mismatches, " normal mismatches" );
+        CollisionCheck collision = check_collision();
+        kl::print( "Check [collision] ", collision.cases, " cases, ", collision.failures, " failures" );
+        StepperCheck stepper = check_stepper( PHYSICS_STEP, MAX_PHYSICS_STEPS );
+        kl::print( "Check [stepper] ", stepper.steady_steps, " steps over 1000x1 ms, ", stepper.capped_steps, " steps in a 2 s frame (", stepper.capped_frames, " capped), ", stepper.frame_time_cases, " frame times, ", stepper.frame_time_mismatches, " mismatches" );
+    }
     if ( window.keyboard.plus.pressed() )
     {
         int ren_dist = world.render_distance() + 1;
@@ -225,6 +333,8 @@ void Game::update_world()
 {
     player.camera.far_plane = max_view_distance();
     world.set_world_center( player.camera.position );
+    world.set_view_direction( player.camera.forward() );
+    world.integrate_streamed();
     hit_block = world.cast_ray( player.camera.ray() );
 }
 
@@ -265,7 +375,7 @@ void Game::update_creative_movement( float delta_t )
     }
 }
 
-void Game::update_survival_movement( float delta_t )
+void Game::update_survival_movement()
 {
     auto& window = world.system.window;
 
@@ -277,46 +387,59 @@ void Game::update_survival_movement( float delta_t )
         speed *= 2.0f;
     }
 
+    flt3 walk;
     if ( window.keyboard.w )
     {
-        player.camera.position.x += forward.x * speed * delta_t;
-        player.camera.position.z += forward.z * speed * delta_t;
+        walk += flt3{ forward.x, 0.0f, forward.z };
     }
     if ( window.keyboard.s )
     {
-        player.camera.position.x -= forward.x * speed * delta_t;
-        player.camera.position.z -= forward.z * speed * delta_t;
+        walk -= flt3{ forward.x, 0.0f, forward.z };
     }
     if ( window.keyboard.d )
     {
-        player.camera.position.x += right.x * speed * delta_t;
-        player.camera.position.z += right.z * speed * delta_t;
+        walk += flt3{ right.x, 0.0f, right.z };
     }
     if ( window.keyboard.a )
     {
-        player.camera.position.x -= right.x * speed * delta_t;
-        player.camera.position.z -= right.z * speed * delta_t;
+        walk -= flt3{ right.x, 0.0f, right.z };
     }
-    if ( window.keyboard.space.pressed() )
+    player.velocity.x = walk.x * speed;
+    player.velocity.z = walk.z * speed;
+    if ( window.keyboard.space.pressed() && player.on_ground )
     {
         player.velocity.y = player.jump_speed;
     }
 }
 
+void Game::update_physics( float delta_t )
+{
+    physics.advance( delta_t, [&]( float step )
+    {
+        player.previous_body_position = player.body_position;
+        update_velocity( step );
+        update_collisions( step );
+    } );
+    player.set_position( kl::lerp( physics.alpha(), player.previous_body_position, player.body_position ) );
+}
+
 void Game::update_velocity( float delta_t )
 {
     player.velocity.y += environment.gravity * delta_t;
-    player.camera.position += player.velocity * delta_t;
 }
 
 void Game::update_collisions( float delta_t )
 {
-    flt3 player_pos = player.position();
-    Block* block = world.get_world_block( BlockPosition::from_flt3( player_pos ) );
-    if ( block && is_block_solid( *block ) )
-    {
-        player_pos.y = floor( player_pos.y + 1.0f );
-        player.set_position( player_pos );
-        player.velocity = {};
-    }
+    CollisionBody body;
+    body.position = player.body_position;
+    body.velocity = player.velocity;
+    body.half_width = Player::BODY_WIDTH * 0.5f;
+    body.height = Player::BODY_HEIGHT;
+    body.step_height = Player::STEP_HEIGHT;
+    body.on_ground = player.on_ground;
+    world.move_bodies( { &body, 1 }, delta_t );
+
+    player.body_position = body.position;
+    player.velocity = body.velocity;
+    player.on_ground = body.on_ground;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "world/world.h"
+#include "game/stepper.h"
 
 
 enum RenderMode : uint8_t
@@ -40,10 +41,16 @@ struct Inventory
 struct Player
 {
     static constexpr float PLAYER_HEIGHT = 1.65f;
+    static constexpr float BODY_HEIGHT = 1.8f;
+    static constexpr float BODY_WIDTH = 0.6f;
+    static constexpr float STEP_HEIGHT = 1.0f;
     static constexpr float CAMERA_SPEED = 5.0f;
 
     kl::Camera camera;
     flt3 velocity;
+    flt3 body_position;
+    flt3 previous_body_position;
+    bool on_ground = false;
 
     float jump_speed = 5.0f;
     float walk_speed = 2.5f;
@@ -53,18 +60,22 @@ struct Player
 
     flt3 position() const;
     void set_position( flt3 const& position );
+    void sync_body();
 };
 
 struct Game
 {
     static constexpr float TRANSITION_DURATION = 2.0f;
     static constexpr float RETURN_DURATION = 2.0f;
+    static constexpr float PHYSICS_STEP = 1.0f / 60.0f;
+    static constexpr int MAX_PHYSICS_STEPS = 8;
 
     RenderMode render_mode = RenderMode::RASTER;
 
     World& world;
     Environment environment;
     Player player;
+    FixedStepper physics;
 
     std::optional<HitPayload> hit_block;
 
@@ -83,7 +94,8 @@ private:
     void update_world();
 
     void update_creative_movement( float delta_t );
-    void update_survival_movement( float delta_t );
+    void update_survival_movement();
+    void update_physics( float delta_t );
     void update_velocity( float delta_t );
     void update_collisions( float delta_t );
 };
@@ -0,0 +1,105 @@
+#include "game/stepper.h"
+
+
+struct SteppedBody
+{
+    flt3 position = { 0.0f, 4.0f, 0.0f };
+    flt3 velocity = { 6.0f, 0.0f, 2.0f };
+    int steps = 0;
+};
+
+static void step_body( SteppedBody& body, float delta_t )
+{
+    body.velocity.y -= 9.81f * delta_t;
+    body.position += body.velocity * delta_t;
+    if ( body.position.y <= 0.0f )
+    {
+        body.position.y = 0.0f;
+        body.velocity.y = 0.0f;
+        body.velocity.x *= 1.0f - 4.0f * delta_t;
+        body.velocity.z *= 1.0f - 4.0f * delta_t;
+    }
+    body.steps += 1;
+}
+
+static SteppedBody run_body( float step, int max_substeps, float frame_time, float duration )
+{
+    FixedStepper stepper;
+    stepper.step = step;
+    stepper.max_substeps = max_substeps;
+
+    SteppedBody body;
+    float elapsed = 0.0f;
+    while ( elapsed < duration )
+    {
+        float delta_t = std::min( frame_time, duration - elapsed );
+        stepper.advance( delta_t, [&]( float dt ) { step_body( body, dt ); } );
+        elapsed += delta_t;
+    }
+    return body;
+}
+
+int FixedStepper::advance( float delta_t, std::function<void( float )> const& simulate )
+{
+    m_accumulator += std::max( delta_t, 0.0f );
+    int step_count = 0;
+    while ( m_accumulator >= step && step_count < max_substeps )
+    {
+        simulate( step );
+        m_accumulator -= step;
+        step_count += 1;
+    }
+    if ( m_accumulator >= step )
+    {
+        float kept = fmod( m_accumulator, step );
+        m_stats.dropped_time += m_accumulator - kept;
+        m_stats.capped_frames += 1;
+        m_accumulator = kept;
+    }
+    m_stats.frames += 1;
+    m_stats.steps += step_count;
+    return step_count;
+}
+
+float FixedStepper::alpha() const
+{
+    return m_accumulator / step;
+}
+
+void FixedStepper::reset()
+{
+    m_accumulator = 0.0f;
+}
+
+StepperStats FixedStepper::stats() const
+{
+    return m_stats;
+}
+
+StepperCheck check_stepper( float step, int max_substeps )
+{
+    StepperCheck check;
+
+    FixedStepper steady;
+    steady.step = step;
+    steady.max_substeps = max_substeps;
+    for ( int i = 0; i < 1000; i++ )
+        check.steady_steps += steady.advance( 0.001f, []( float ) {} );
+
+    FixedStepper capped;
+    capped.step = step;
+    capped.max_substeps = max_substeps;
+    check.capped_steps = capped.advance( 2.0f, []( float ) {} );
+    check.capped_frames = capped.stats().capped_frames;
+
+    float duration = 120.5f * step;
+    SteppedBody reference = run_body( step, max_substeps, 0.001f, duration );
+    for ( float frame_time : { 0.001f, 0.0167f, 0.05f } )
+    {
+        SteppedBody body = run_body( step, max_substeps, frame_time, duration );
+        check.frame_time_cases += 1;
+        if ( body.steps != reference.steps || body.position != reference.position || body.velocity != reference.velocity )
+            check.frame_time_mismatches += 1;
+    }
+    return check;
+}
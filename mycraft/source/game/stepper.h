@@ -0,0 +1,39 @@
+#pragma once
+
+#include "global/defines.h"
+
+
+struct StepperStats
+{
+    uint64_t frames = 0;
+    uint64_t steps = 0;
+    uint64_t capped_frames = 0;
+    float dropped_time = 0.0f;
+};
+
+struct StepperCheck
+{
+    int steady_steps = 0;
+    int capped_steps = 0;
+    uint64_t capped_frames = 0;
+    int frame_time_cases = 0;
+    int frame_time_mismatches = 0;
+};
+
+struct FixedStepper
+{
+    float step = 1.0f / 60.0f;
+    int max_substeps = 5;
+
+    int advance( float delta_t, std::function<void( float )> const& simulate );
+    float alpha() const;
+    void reset();
+
+    StepperStats stats() const;
+
+private:
+    float m_accumulator = 0.0f;
+    StepperStats m_stats;
+};
+
+StepperCheck check_stepper( float step, int max_substeps );
@@ -5,6 +5,7 @@
 
 inline constexpr int CHUNK_WIDTH = 16;
 inline constexpr int CHUNK_HEIGHT = 64;
+inline constexpr int CHUNK_BLOCK_COUNT = CHUNK_WIDTH * CHUNK_WIDTH * CHUNK_HEIGHT;
 inline constexpr flt3 CHUNK_SIZE = flt3{ float( CHUNK_WIDTH ), float( CHUNK_HEIGHT ), float( CHUNK_WIDTH ) };
 inline constexpr flt3 CHUNK_HALF = CHUNK_SIZE * 0.5f;
 
@@ -41,12 +41,20 @@ Renderer::Renderer( Game& game )
         { "KL_Texture", 0, DXGI_FORMAT_R8_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
         { "KL_Ambient", 0, DXGI_FORMAT_R8_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
         { "KL_Block", 0, DXGI_FORMAT_R8_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "KL_Tiling", 0, DXGI_FORMAT_R8_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
     };
 
+    std::vector<dx::LayoutDescriptor> packed_chunk_input_layout = {
+        { "KL_Packed", 0, DXGI_FORMAT_R32G32_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    };
+    std::string packed_define = "#define PACKED_VERTICES\n";
+
     draw_sky_shaders = gpu.create_shaders( kl::read_file( "shaders/draw_sky.hlsl" ) );
     draw_hit_block_shaders = gpu.create_shaders( kl::read_file( "shaders/draw_hit_block.hlsl" ) );
     raster_shadow_shaders = gpu.create_shaders( kl::read_file( "shaders/raster_shadows.hlsl" ), chunk_input_layout );
     raster_chunk_shaders = gpu.create_shaders( kl::read_file( "shaders/raster_chunks.hlsl" ), chunk_input_layout );
+    raster_shadow_packed_shaders = gpu.create_shaders( packed_define + kl::read_file( "shaders/raster_shadows.hlsl" ), packed_chunk_input_layout );
+    raster_chunk_packed_shaders = gpu.create_shaders( packed_define + kl::read_file( "shaders/raster_chunks.hlsl" ), packed_chunk_input_layout );
     tracing_world_shaders = gpu.create_shaders( kl::read_file( "shaders/tracing_world.hlsl" ) );
 
     sky_mesh = gpu.create_cube_mesh( 1.0f );
@@ -72,6 +80,10 @@ Renderer::Renderer( Game& game )
         } );
     tracing_mesh = gpu.create_screen_mesh();
 
+    std::vector<uint32_t> quad_indices;
+    make_quad_indices( MAX_CHUNK_QUADS, quad_indices );
+    quad_index_buffer = gpu.create_index_buffer( quad_indices );
+
     atlas_texture = gpu.create_texture( kl::Image( "textures/blocks.png" ) );
     atlas_shader_view = gpu.create_shader_view( atlas_texture, nullptr );
 
@@ -184,6 +196,7 @@ void Renderer::raster_shadows()
         flt3 CAMERA_ORIGIN;
         float ELAPSED_TIME;
         float RENDER_DISTANCE;
+        flt2 CHUNK_ORIGIN;
     } cb = {};
 
     cb.VP = game.environment.sun.matrix( inv_shadow_cam() );
@@ -200,12 +213,25 @@ void Renderer::raster_shadows()
     sun_plane.position = sun_pos.xyz();
     sun_plane.set_normal( game.environment.sun.direction() );
 
-    gpu.bind_shaders( raster_shadow_shaders );
+    bool packed = game.world.vertex_format() == VertexFormat::PACKED;
+    kl::Shaders& shaders = packed ? raster_shadow_packed_shaders : raster_shadow_shaders;
+    gpu.bind_shaders( shaders );
     for ( int i = 0; i < game.world.chunk_count(); i++ )
     {
-        if ( game.world.chunk_visible( sun_plane, i ) )
+        if ( !game.world.chunk_visible( sun_plane, i ) )
+            continue;
+
+        dx::Buffer const& buffer = game.world.get_chunk( i ).buffer;
+        if ( packed )
         {
-            gpu.draw( game.world.get_chunk( i ).buffer, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, sizeof( Vertex ) );
+            ChunkPosition chunk_pos = game.world.chunk_position( i );
+            cb.CHUNK_ORIGIN = flt2{ float( chunk_pos.x ), float( chunk_pos.z ) };
+            shaders.upload( cb );
+            draw_packed_chunk( buffer );
+        }
+        else
+        {
+            gpu.draw( buffer, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, sizeof( Vertex ) );
         }
     }
 
@@ -235,6 +261,7 @@ void Renderer::raster_chunks()
         flt3 SUN_DIRECTION;
         float RENDER_DISTANCE;
         flt2 SHADOW_TEXEL_SIZE;
+        flt2 CHUNK_ORIGIN;
     } cb = {};
 
     cb.VP = game.player.camera.matrix();
@@ -250,12 +277,25 @@ void Renderer::raster_chunks()
     camera_plane.position = game.player.camera.position;
     camera_plane.set_normal( game.player.camera.forward() );
 
-    gpu.bind_shaders( raster_chunk_shaders );
+    bool packed = game.world.vertex_format() == VertexFormat::PACKED;
+    kl::Shaders& shaders = packed ? raster_chunk_packed_shaders : raster_chunk_shaders;
+    gpu.bind_shaders( shaders );
     for ( int i = 0; i < game.world.chunk_count(); i++ )
     {
-        if ( game.world.chunk_visible( camera_plane, i ) )
+        if ( !game.world.chunk_visible( camera_plane, i ) )
+            continue;
+
+        dx::Buffer const& buffer = game.world.get_chunk( i ).buffer;
+        if ( packed )
         {
-            gpu.draw( game.world.get_chunk( i ).buffer, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, sizeof( Vertex ) );
+            ChunkPosition chunk_pos = game.world.chunk_position( i );
+            cb.CHUNK_ORIGIN = flt2{ float( chunk_pos.x ), float( chunk_pos.z ) };
+            shaders.upload( cb );
+            draw_packed_chunk( buffer );
+        }
+        else
+        {
+            gpu.draw( buffer, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, sizeof( Vertex ) );
         }
     }
 
@@ -281,12 +321,17 @@ void Renderer::tracing_world()
         flt3 CAMERA_POSITION;
         float RENDER_DISTANCE;
         flt3 SUN_DIRECTION;
+        float WIDTH_CHUNKS;
+        flt2 FIRST_CHUNK;
     } cb = {};
 
+    ChunkPosition first_chunk_pos = game.world.first_chunk_pos();
     cb.INV_CAM = kl::inverse( game.player.camera.matrix() );
     cb.CAMERA_POSITION = game.player.camera.position;
     cb.RENDER_DISTANCE = (float) game.world.render_distance();
     cb.SUN_DIRECTION = game.environment.sun.direction();
+    cb.WIDTH_CHUNKS = (float) game.world.width_chunks();
+    cb.FIRST_CHUNK = flt2{ float( first_chunk_pos.x ), float( first_chunk_pos.z ) };
     tracing_world_shaders.upload( cb );
 
     gpu.bind_shaders( tracing_world_shaders );
@@ -296,6 +341,19 @@ void Renderer::tracing_world()
     gpu.unbind_shader_view_for_pixel_shader( 0 );
 }
 
+void Renderer::draw_packed_chunk( dx::Buffer const& buffer ) const
+{
+    if ( !buffer )
+        return;
+
+    auto& gpu = game.world.system.gpu;
+    UINT quad_count = gpu.vertex_buffer_size( buffer, sizeof( PackedQuad ) );
+    gpu.set_draw_type( D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+    gpu.bind_vertex_buffer( buffer, 0, 0, sizeof( PackedVertex ) );
+    gpu.bind_index_buffer( quad_index_buffer, 0 );
+    gpu.draw_indexed( quad_count * 6, 0, 0 );
+}
+
 mat4 Renderer::inv_shadow_cam() const
 {
     kl::Camera camera = game.player.camera;
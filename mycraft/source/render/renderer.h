@@ -25,11 +25,14 @@ struct Renderer
     kl::Shaders draw_hit_block_shaders;
     kl::Shaders raster_shadow_shaders;
     kl::Shaders raster_chunk_shaders;
+    kl::Shaders raster_shadow_packed_shaders;
+    kl::Shaders raster_chunk_packed_shaders;
     kl::Shaders tracing_world_shaders;
 
     dx::Buffer sky_mesh;
     dx::Buffer hit_block_mesh;
     dx::Buffer tracing_mesh;
+    dx::Buffer quad_index_buffer;
 
     dx::Texture atlas_texture;
     dx::ShaderView atlas_shader_view;
@@ -49,5 +52,7 @@ private:
     void raster_chunks();
     void tracing_world();
 
+    void draw_packed_chunk( dx::Buffer const& buffer ) const;
+
     mat4 inv_shadow_cam() const;
 };
@@ -119,6 +119,94 @@ static const std::vector<Quad> PETTLE_QUADS = []() -> std::vector<Quad>
     return quads;
 }();
 
+struct FaceInfo
+{
+    BlockPosition normal;
+    BlockPosition corners[4];
+    BlockPosition ring_offsets[8];
+    int corner_quadrants[4] = {};
+    int cycle[4] = {};
+    int u_axis = 0;
+    int v_axis = 0;
+};
+
+static constexpr int get_axis( BlockPosition const& pos, int axis )
+{
+    return axis == 0 ? pos.x : (axis == 1 ? pos.y : pos.z);
+}
+
+static constexpr int find_axis( BlockPosition const& delta )
+{
+    return delta.x != 0 ? 0 : (delta.y != 0 ? 1 : 2);
+}
+
+static BlockPosition round_position( flt3 const& position )
+{
+    return { (int) round( position.x ), (int) round( position.y ), (int) round( position.z ) };
+}
+
+static const std::vector<FaceInfo> FACE_INFOS = []() -> std::vector<FaceInfo>
+{
+    std::vector<FaceInfo> infos;
+    infos.resize( BLOCK_QUADS.size() );
+    for ( int i = 0; i < (int) infos.size(); i++ )
+    {
+        Quad const& quad = BLOCK_QUADS[i];
+        triangle triangle;
+        triangle.a.position = quad.triangles[0].vertices[0].position;
+        triangle.b.position = quad.triangles[0].vertices[1].position;
+        triangle.c.position = quad.triangles[0].vertices[2].position;
+
+        FaceInfo& info = infos[i];
+        info.normal = round_position( triangle.normal() );
+        for ( auto& triangle : quad.triangles )
+        {
+            for ( auto& vertex : triangle.vertices )
+                info.corners[vertex.texture] = round_position( vertex.position );
+        }
+        info.u_axis = find_axis( info.corners[2] - info.corners[1] );
+        info.v_axis = find_axis( info.corners[0] - info.corners[1] );
+
+        for ( int j = 0; j < 3; j++ )
+            info.cycle[j] = quad.triangles[0].vertices[j].texture;
+        for ( auto& vertex : quad.triangles[1].vertices )
+        {
+            if ( vertex.texture != info.cycle[0] && vertex.texture != info.cycle[1] && vertex.texture != info.cycle[2] )
+                info.cycle[3] = vertex.texture;
+        }
+
+        for ( int dv = -1; dv <= 1; dv++ )
+        {
+            for ( int du = -1; du <= 1; du++ )
+            {
+                if ( du == 0 && dv == 0 )
+                    continue;
+
+                int offset[3] = { info.normal.x, info.normal.y, info.normal.z };
+                offset[info.u_axis] += du;
+                offset[info.v_axis] += dv;
+                info.ring_offsets[ambient_ring_bit( du, dv )] = { offset[0], offset[1], offset[2] };
+            }
+        }
+        for ( int j = 0; j < 4; j++ )
+            info.corner_quadrants[j] = get_axis( info.corners[j], info.u_axis ) | (get_axis( info.corners[j], info.v_axis ) << 1);
+    }
+    return infos;
+}();
+
+static flt3 pettle_offset( int diagonal, int texture )
+{
+    for ( auto& triangle : PETTLE_QUADS[diagonal].triangles )
+    {
+        for ( auto& vertex : triangle.vertices )
+        {
+            if ( vertex.texture == texture )
+                return vertex.position;
+        }
+    }
+    return {};
+}
+
 static byte calc_ambient( BlockPosition const& block_pos, BlockTest const& block_test )
 {
     static constexpr BlockPosition adjacents[6] = {
@@ -132,33 +220,342 @@ static byte calc_ambient( BlockPosition const& block_pos, BlockTest const& block
         if ( !block_test( block_pos + adj ) )
             counter += 1;
     }
-    float perc = float( counter ) / std::size( adjacents );
-    return byte( perc * 255 );
+    return ambient_level( counter );
 }
 
-void block_to_quads( BlockPosition const& block_pos, Block block, std::vector<Quad>& out_quads, BlockTest const& block_test )
+BlockPosition face_normal( int face )
+{
+    return FACE_INFOS[face].normal;
+}
+
+BlockPosition face_corner( int face, int corner )
+{
+    return FACE_INFOS[face].corners[corner];
+}
+
+BlockPosition face_ring_offset( int face, int bit )
 {
-    for ( Quad quad : BLOCK_QUADS )
+    return FACE_INFOS[face].ring_offsets[bit];
+}
+
+void ring_ambient( int face, int ring, byte( &out_ambient )[4] )
+{
+    FaceInfo const& info = FACE_INFOS[face];
+    auto& levels = CORNER_AMBIENT[ring];
+    for ( int i = 0; i < 4; i++ )
+        out_ambient[i] = levels[info.corner_quadrants[i]];
+}
+
+void face_ambient( BlockPosition const& block_pos, int face, byte( &out_ambient )[4], BlockTest const& block_test )
+{
+    FaceInfo const& info = FACE_INFOS[face];
+    int ring = 0;
+    for ( int i = 0; i < 8; i++ )
+    {
+        if ( block_test( block_pos + info.ring_offsets[i] ) )
+            ring |= 1 << i;
+    }
+    ring_ambient( face, ring, out_ambient );
+}
+
+void face_to_quad( BlockPosition const& block_pos, BlockPosition const& size, int face, Block block, byte const( &ambient )[4], Quad& out_quad )
+{
+    FaceInfo const& info = FACE_INFOS[face];
+    byte tiling = make_tiling( get_axis( size, info.u_axis ), get_axis( size, info.v_axis ) );
+
+    Vertex vertices[4];
+    for ( int i = 0; i < 4; i++ )
+    {
+        int texture = info.cycle[i];
+        BlockPosition corner = info.corners[texture];
+        BlockPosition offset{ corner.x * size.x, corner.y * size.y, corner.z * size.z };
+        Vertex& vertex = vertices[i];
+        vertex.position = (block_pos + offset).to_flt3();
+        vertex.texture = byte( texture );
+        vertex.ambient = ambient[texture];
+        vertex.block = block;
+        vertex.tiling = tiling;
+    }
+
+    int first = ambient[info.cycle[0]] + ambient[info.cycle[2]] < ambient[info.cycle[1]] + ambient[info.cycle[3]] ? 1 : 0;
+    out_quad.triangles[0].vertices[0] = vertices[first];
+    out_quad.triangles[0].vertices[1] = vertices[(first + 1) % 4];
+    out_quad.triangles[0].vertices[2] = vertices[(first + 2) % 4];
+    out_quad.triangles[1].vertices[0] = vertices[first];
+    out_quad.triangles[1].vertices[1] = vertices[(first + 2) % 4];
+    out_quad.triangles[1].vertices[2] = vertices[(first + 3) % 4];
+}
+
+PackedQuad pack_quad( Quad const& quad, ChunkPosition const& chunk_pos )
+{
+    Vertex const* first = quad.triangles[0].vertices;
+    Vertex const* slots[4] = { nullptr, &first[0], &first[1], &first[2] };
+    for ( auto& vertex : quad.triangles[1].vertices )
+    {
+        if ( vertex.texture != first[0].texture && vertex.texture != first[1].texture && vertex.texture != first[2].texture )
+            slots[0] = &vertex;
+    }
+
+    flt3 origin = chunk_pos.to_flt3();
+    bool pettle = is_block_pettle( first[0].block );
+    int face = 0;
+    BlockPosition cell;
+    if ( pettle )
+    {
+        flt3 min_position = slots[1]->position;
+        for ( auto slot : slots )
+            min_position = kl::min( min_position, slot->position );
+        cell = BlockPosition::from_flt3( min_position - origin );
+
+        for ( auto slot : slots )
+        {
+            if ( slot->texture != 0 )
+                continue;
+            flt3 local = slot->position - origin - cell.to_flt3();
+            face = BLOCK_FACE_COUNT + (abs( local.x - local.z ) > 0.5f ? 1 : 0);
+        }
+    }
+    else
     {
         triangle triangle;
-        triangle.a.position = quad.triangles[0].vertices[0].position;
-        triangle.b.position = quad.triangles[0].vertices[1].position;
-        triangle.c.position = quad.triangles[0].vertices[2].position;
-        flt3 triangle_normal = triangle.normal();
+        triangle.a.position = first[0].position;
+        triangle.b.position = first[1].position;
+        triangle.c.position = first[2].position;
+        BlockPosition normal = round_position( triangle.normal() );
+        while ( face < BLOCK_FACE_COUNT - 1 && face_normal( face ) != normal )
+            face += 1;
+    }
 
-        BlockPosition forward_pos = BlockPosition::from_flt3( block_pos.to_flt3() + flt3{ 0.1f } + triangle_normal );
-        if ( block_test( forward_pos ) )
-            continue;
+    PackedQuad packed;
+    for ( int i = 0; i < 4; i++ )
+    {
+        Vertex const& vertex = *slots[i];
+        BlockPosition local = pettle ? cell : round_position( vertex.position - origin );
+        packed.vertices[i].geometry = uint32_t( local.x )
+            | (uint32_t( local.y ) << 5)
+            | (uint32_t( local.z ) << 12)
+            | (uint32_t( face ) << 17)
+            | (uint32_t( vertex.texture ) << 20)
+            | (uint32_t( vertex.tiling ) << 22);
+        packed.vertices[i].material = uint32_t( vertex.ambient ) | (uint32_t( vertex.block ) << 8);
+    }
+    return packed;
+}
 
-        for ( auto& triangle : quad.triangles )
+Quad unpack_quad( PackedQuad const& packed, ChunkPosition const& chunk_pos )
+{
+    static constexpr int slots[2][3] = { { 1, 2, 3 }, { 1, 3, 0 } };
+    Quad quad;
+    for ( int i = 0; i < 2; i++ )
+    {
+        for ( int j = 0; j < 3; j++ )
+            quad.triangles[i].vertices[j] = unpack_vertex( packed.vertices[slots[i][j]], chunk_pos );
+    }
+    return quad;
+}
+
+Vertex unpack_vertex( PackedVertex const& packed, ChunkPosition const& chunk_pos )
+{
+    BlockIndex local{
+        int( packed.geometry & 0x1F ),
+        int( (packed.geometry >> 5) & 0x7F ),
+        int( (packed.geometry >> 12) & 0x1F ),
+    };
+    int face = int( (packed.geometry >> 17) & 0x07 );
+
+    Vertex vertex;
+    vertex.texture = byte( (packed.geometry >> 20) & 0x03 );
+    vertex.tiling = byte( (packed.geometry >> 22) & 0xFF );
+    vertex.ambient = byte( packed.material & 0xFF );
+    vertex.block = Block( (packed.material >> 8) & 0xFF );
+    vertex.position = BlockPosition::from_index( chunk_pos, local ).to_flt3();
+    if ( face >= BLOCK_FACE_COUNT )
+        vertex.position = pettle_offset( face - BLOCK_FACE_COUNT, vertex.texture ) + vertex.position;
+    return vertex;
+}
+
+void make_quad_indices( int quad_count, std::vector<uint32_t>& out_indices )
+{
+    static constexpr uint32_t pattern[6] = { 1, 2, 3, 1, 3, 0 };
+    out_indices.reserve( out_indices.size() + quad_count * std::size( pattern ) );
+    for ( int i = 0; i < quad_count; i++ )
+    {
+        for ( uint32_t index : pattern )
+            out_indices.push_back( uint32_t( i ) * 4 + index );
+    }
+}
+
+static bool same_vertex( Vertex const& first, Vertex const& second )
+{
+    return (first.position - second.position).length() < 1e-4f
+        && first.texture == second.texture
+        && first.ambient == second.ambient
+        && first.block == second.block
+        && first.tiling == second.tiling;
+}
+
+static bool same_triangle( Triangle const& first, Triangle const& second )
+{
+    for ( int rotation = 0; rotation < 3; rotation++ )
+    {
+        bool same = true;
+        for ( int i = 0; i < 3; i++ )
+            same = same && same_vertex( first.vertices[i], second.vertices[(i + rotation) % 3] );
+        if ( same )
+            return true;
+    }
+    return false;
+}
+
+static bool same_quad( Quad const& first, Quad const& second )
+{
+    return same_triangle( first.triangles[0], second.triangles[0] ) && same_triangle( first.triangles[1], second.triangles[1] );
+}
+
+PackCheck check_packing()
+{
+    static constexpr ChunkPosition chunk_positions[] = { { 0, 0 }, { -CHUNK_WIDTH * 3, CHUNK_WIDTH * 5 } };
+    static constexpr Block blocks[] = { Block::STONE, Block::GRASS, Block::COBBLE, Block::PLANKS };
+    static constexpr Block pettles[] = { Block::COBWEB, Block::ROSE, Block::DANDELION, Block::SAPLING };
+    static constexpr byte ambients[][4] = {
+        { 0, 0, 0, 0 },
+        { 255, 255, 255, 255 },
+        { 0, 255, 85, 170 },
+        { 255, 0, 170, 85 },
+    };
+    static constexpr BlockIndex first_cell{ 0, 0, 0 };
+    static constexpr BlockIndex last_cell{ CHUNK_WIDTH - 1, CHUNK_HEIGHT - 1, CHUNK_WIDTH - 1 };
+
+    std::vector<std::pair<ChunkPosition, Quad>> quads;
+    for ( auto& chunk_pos : chunk_positions )
+    {
+        for ( int face = 0; face < BLOCK_FACE_COUNT; face++ )
         {
-            for ( auto& vertex : triangle.vertices )
+            BlockPosition normal = face_normal( face );
+            BlockPosition max_size{ normal.x ? 1 : MAX_TILING, normal.y ? 1 : MAX_TILING, normal.z ? 1 : MAX_TILING };
+            for ( Block block : blocks )
             {
-                vertex.position += block_pos.to_flt3();
-                vertex.ambient = calc_ambient( BlockPosition::from_flt3( vertex.position + flt3{ 0.1f } ), block_test );
-                vertex.block = block;
+                for ( auto& ambient : ambients )
+                {
+                    Quad quad;
+                    face_to_quad( BlockPosition::from_index( chunk_pos, first_cell ), max_size, face, block, ambient, quad );
+                    quads.emplace_back( chunk_pos, quad );
+                    face_to_quad( BlockPosition::from_index( chunk_pos, last_cell ), { 1, 1, 1 }, face, block, ambient, quad );
+                    quads.emplace_back( chunk_pos, quad );
+                }
+            }
+        }
+
+        for ( Block block : pettles )
+        {
+            for ( auto& cell : { first_cell, last_cell } )
+            {
+                BlockPosition block_pos = BlockPosition::from_index( chunk_pos, cell );
+                std::vector<Quad> pettle_quads;
+                pettle_to_quads( block_pos, block, pettle_quads, []( BlockPosition const& ) { return false; } );
+                pettle_to_quads( block_pos, block, pettle_quads, [&]( BlockPosition const& test_pos ) { return test_pos.y <= block_pos.y && test_pos != block_pos; } );
+                for ( auto& quad : pettle_quads )
+                    quads.emplace_back( chunk_pos, quad );
+            }
+        }
+    }
+
+    PackCheck check;
+    check.quad_count = (int) quads.size();
+    for ( auto& [chunk_pos, quad] : quads )
+    {
+        if ( !same_quad( unpack_quad( pack_quad( quad, chunk_pos ), chunk_pos ), quad ) )
+            check.mismatches += 1;
+    }
+    return check;
+}
+
+AmbientCheck check_ambient()
+{
+    static constexpr byte expected_levels[8] = { 255, 170, 170, 0, 170, 85, 85, 0 };
+    static constexpr BlockPosition block_pos{ 5, 10, 7 };
+
+    AmbientCheck check;
+    for ( int face = 0; face < BLOCK_FACE_COUNT; face++ )
+    {
+        BlockPosition normal = face_normal( face );
+        for ( int corner = 0; corner < 4; corner++ )
+        {
+            BlockPosition corner_pos = face_corner( face, corner );
+            BlockPosition tangents[2];
+            int tangent_count = 0;
+            for ( int axis = 0; axis < 3; axis++ )
+            {
+                if ( get_axis( normal, axis ) != 0 )
+                    continue;
+
+                int offset[3] = {};
+                offset[axis] = get_axis( corner_pos, axis ) ? 1 : -1;
+                tangents[tangent_count++] = { offset[0], offset[1], offset[2] };
+            }
+
+            BlockPosition front = block_pos + normal;
+            for ( int combo = 0; combo < 8; combo++ )
+            {
+                std::vector<BlockPosition> occupied;
+                if ( combo & 1 )
+                    occupied.push_back( front + tangents[0] );
+                if ( combo & 2 )
+                    occupied.push_back( front + tangents[1] );
+                if ( combo & 4 )
+                    occupied.push_back( front + tangents[0] + tangents[1] );
+
+                byte ambient[4] = {};
+                face_ambient( block_pos, face, ambient, [&]( BlockPosition const& test_pos )
+                {
+                    return std::find( occupied.begin(), occupied.end(), test_pos ) != occupied.end();
+                } );
+                check.corner_cases += 1;
+                if ( ambient[corner] != expected_levels[combo] )
+                    check.corner_mismatches += 1;
+            }
+
+            for ( bool dark : { true, false } )
+            {
+                byte ambient[4] = {};
+                for ( auto& level : ambient )
+                    level = dark ? 255 : 0;
+                ambient[corner] = dark ? 0 : 255;
+
+                Quad quad;
+                face_to_quad( block_pos, { 1, 1, 1 }, face, Block::STONE, ambient, quad );
+                bool on_diagonal = quad.triangles[0].vertices[0].texture == corner || quad.triangles[0].vertices[2].texture == corner;
+                bool valid = on_diagonal != dark;
+                for ( auto& quad_triangle : quad.triangles )
+                {
+                    triangle triangle;
+                    triangle.a.position = quad_triangle.vertices[0].position;
+                    triangle.b.position = quad_triangle.vertices[1].position;
+                    triangle.c.position = quad_triangle.vertices[2].position;
+                    valid = valid && round_position( triangle.normal() ) == normal;
+                }
+                check.flip_cases += 1;
+                if ( !valid )
+                    check.flip_mismatches += 1;
             }
         }
+    }
+    return check;
+}
+
+void block_to_quads( BlockPosition const& block_pos, Block block, std::vector<Quad>& out_quads, BlockTest const& block_test )
+{
+    static constexpr BlockPosition unit_size{ 1, 1, 1 };
+    for ( int face = 0; face < BLOCK_FACE_COUNT; face++ )
+    {
+        if ( block_test( block_pos + face_normal( face ) ) )
+            continue;
+
+        byte ambient[4] = {};
+        face_ambient( block_pos, face, ambient, block_test );
+
+        Quad quad;
+        face_to_quad( block_pos, unit_size, face, block, ambient, quad );
         out_quads.push_back( quad );
     }
 }
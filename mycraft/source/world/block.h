@@ -5,6 +5,16 @@
 
 using BlockTest = std::function<bool( BlockPosition const& )>;
 
+inline constexpr int BLOCK_FACE_COUNT = 6;
+inline constexpr int MAX_TILING = 16;
+inline constexpr int MAX_CHUNK_QUADS = CHUNK_BLOCK_COUNT * BLOCK_FACE_COUNT;
+
+enum VertexFormat : uint8_t
+{
+    FULL = 0,
+    PACKED,
+};
+
 enum Block : byte
 {
     AIR = ATLAS_POS( 0, 15 ),
@@ -26,6 +36,7 @@ struct Vertex
     byte texture = 0;
     byte ambient = 0;
     Block block = Block::AIR;
+    byte tiling = 0;
 };
 
 struct Triangle
@@ -38,6 +49,32 @@ struct Quad
     Triangle triangles[2] = {};
 };
 
+// geometry: x(5) y(7) z(5) face(3) texture(2) tiling(8), material: ambient(8) block(8)
+struct PackedVertex
+{
+    uint32_t geometry = 0;
+    uint32_t material = 0;
+};
+
+struct PackedQuad
+{
+    PackedVertex vertices[4] = {};
+};
+
+struct PackCheck
+{
+    int quad_count = 0;
+    int mismatches = 0;
+};
+
+struct AmbientCheck
+{
+    int corner_cases = 0;
+    int corner_mismatches = 0;
+    int flip_cases = 0;
+    int flip_mismatches = 0;
+};
+
 constexpr bool is_block_gas( Block block )
 {
     return block == Block::AIR;
@@ -87,5 +124,57 @@ constexpr flt2 atlas_uv( Block block, flt2 uv )
     return (uv + atlas_pos( block )) * ATLAS_DIVIDER;
 }
 
+constexpr byte ambient_level( int open_count )
+{
+    return byte( float( open_count ) / BLOCK_FACE_COUNT * 255 );
+}
+
+constexpr int ambient_ring_bit( int du, int dv )
+{
+    int index = (du + 1) + (dv + 1) * 3;
+    return index > 4 ? index - 1 : index;
+}
+
+constexpr byte corner_ambient_level( bool side_u, bool side_v, bool diagonal )
+{
+    int open_count = (side_u && side_v) ? 0 : 3 - int( side_u ) - int( side_v ) - int( diagonal );
+    return byte( open_count * 255 / 3 );
+}
+
+inline constexpr auto CORNER_AMBIENT = []()
+{
+    std::array<std::array<byte, 4>, 256> table{};
+    for ( int ring = 0; ring < 256; ring++ )
+    {
+        for ( int quadrant = 0; quadrant < 4; quadrant++ )
+        {
+            int du = (quadrant & 1) ? 1 : -1;
+            int dv = (quadrant & 2) ? 1 : -1;
+            auto occupied = [ring]( int u, int v ) { return bool( (ring >> ambient_ring_bit( u, v )) & 1 ); };
+            table[ring][quadrant] = corner_ambient_level( occupied( du, 0 ), occupied( 0, dv ), occupied( du, dv ) );
+        }
+    }
+    return table;
+}();
+
+constexpr byte make_tiling( int tiles_u, int tiles_v )
+{
+    return byte( ((tiles_u - 1) & 0x0F) | (((tiles_v - 1) & 0x0F) << 4) );
+}
+
+BlockPosition face_normal( int face );
+BlockPosition face_corner( int face, int corner );
+BlockPosition face_ring_offset( int face, int bit );
+void ring_ambient( int face, int ring, byte( &out_ambient )[4] );
+void face_ambient( BlockPosition const& block_pos, int face, byte( &out_ambient )[4], BlockTest const& block_test );
+void face_to_quad( BlockPosition const& block_pos, BlockPosition const& size, int face, Block block, byte const( &ambient )[4], Quad& out_quad );
+
+PackedQuad pack_quad( Quad const& quad, ChunkPosition const& chunk_pos );
+Quad unpack_quad( PackedQuad const& packed, ChunkPosition const& chunk_pos );
+Vertex unpack_vertex( PackedVertex const& packed, ChunkPosition const& chunk_pos );
+void make_quad_indices( int quad_count, std::vector<uint32_t>& out_indices );
+PackCheck check_packing();
+AmbientCheck check_ambient();
+
 void block_to_quads( BlockPosition const& block_pos, Block block, std::vector<Quad>& out_quads, BlockTest const& block_test );
 void pettle_to_quads( BlockPosition const& block_pos, Block block, std::vector<Quad>& out_quads, BlockTest const& block_test );
@@ -0,0 +1,112 @@
+#include "world/cache.h"
+
+
+ChunkCache::ChunkCache( kl::GPU& gpu )
+    : m_gpu( gpu )
+{}
+
+void ChunkCache::insert( ChunkPosition const& chunk_pos, Chunk&& chunk, MeshMode mesh_mode, VertexFormat vertex_format )
+{
+    std::pair key{ chunk_pos.x, chunk_pos.z };
+    if ( auto it = m_lookup.find( key ); it != m_lookup.end() )
+        erase( it->second );
+
+    CachedChunk cached;
+    cached.blocks = std::move( chunk.blocks );
+    cached.mesh_mode = mesh_mode;
+    cached.vertex_format = vertex_format;
+    cached.byte_size = cached.blocks.byte_size();
+    if ( keep_meshes )
+    {
+        cached.buffer = std::move( chunk.buffer );
+        cached.has_mesh = true;
+        if ( cached.buffer )
+            cached.byte_size += m_gpu.buffer_size( cached.buffer );
+
+        cached.quads_mode = chunk.quads_mode;
+        for ( int i = 0; i < PaletteStorage::SECTION_COUNT; i++ )
+        {
+            cached.section_quads[i] = std::move( chunk.section_quads[i] );
+            cached.section_slots[i] = chunk.section_slots[i];
+            cached.byte_size += cached.section_quads[i].size() * sizeof( Quad );
+        }
+    }
+    if ( cached.byte_size > budget_bytes )
+        return;
+
+    m_resident_bytes += cached.byte_size;
+    m_entries.emplace_front( key, std::move( cached ) );
+    m_lookup[key] = m_entries.begin();
+
+    while ( m_resident_bytes > budget_bytes )
+    {
+        erase( std::prev( m_entries.end() ) );
+        m_evictions += 1;
+    }
+}
+
+bool ChunkCache::take( ChunkPosition const& chunk_pos, CachedChunk& out_chunk )
+{
+    auto it = m_lookup.find( { chunk_pos.x, chunk_pos.z } );
+    if ( it == m_lookup.end() )
+    {
+        m_misses += 1;
+        return false;
+    }
+
+    out_chunk = std::move( it->second->second );
+    erase( it->second );
+    m_hits += 1;
+    return true;
+}
+
+void ChunkCache::drop_mesh( ChunkPosition const& chunk_pos )
+{
+    auto it = m_lookup.find( { chunk_pos.x, chunk_pos.z } );
+    if ( it == m_lookup.end() || !it->second->second.has_mesh )
+        return;
+
+    CachedChunk& cached = it->second->second;
+    m_resident_bytes -= cached.byte_size;
+    cached.buffer = {};
+    cached.quads_mode = std::nullopt;
+    for ( auto& quads : cached.section_quads )
+        quads = {};
+    cached.has_mesh = false;
+    cached.byte_size = cached.blocks.byte_size();
+    m_resident_bytes += cached.byte_size;
+}
+
+void ChunkCache::erase( ChunkPosition const& chunk_pos )
+{
+    if ( auto it = m_lookup.find( { chunk_pos.x, chunk_pos.z } ); it != m_lookup.end() )
+        erase( it->second );
+}
+
+void ChunkCache::clear()
+{
+    m_entries.clear();
+    m_lookup.clear();
+    m_resident_bytes = 0;
+}
+
+CacheStats ChunkCache::stats() const
+{
+    CacheStats stats;
+    stats.resident_chunks = (int) m_entries.size();
+    stats.resident_bytes = m_resident_bytes;
+    stats.budget_bytes = budget_bytes;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    if ( m_hits + m_misses > 0 )
+        stats.hit_ratio = float( m_hits ) / float( m_hits + m_misses );
+    return stats;
+}
+
+void ChunkCache::erase( std::list<Entry>::iterator it )
+{
+    m_resident_bytes -= it->second.byte_size;
+    m_lookup.erase( it->first );
+    m_entries.erase( it );
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "world/chunk.h"
+
+
+struct CachedChunk
+{
+    PaletteStorage blocks;
+    std::vector<Quad> section_quads[PaletteStorage::SECTION_COUNT];
+    std::optional<MeshMode> quads_mode;
+    dx::Buffer buffer;
+    SectionSlot section_slots[PaletteStorage::SECTION_COUNT];
+    MeshMode mesh_mode = MeshMode::GREEDY;
+    VertexFormat vertex_format = VertexFormat::FULL;
+    bool has_mesh = false;
+    size_t byte_size = 0;
+};
+
+struct CacheStats
+{
+    int resident_chunks = 0;
+    size_t resident_bytes = 0;
+    size_t budget_bytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    float hit_ratio = 0.0f;
+};
+
+struct ChunkCache
+{
+    size_t budget_bytes = 64ull * 1024 * 1024;
+    bool keep_meshes = true;
+
+    ChunkCache( kl::GPU& gpu );
+
+    void insert( ChunkPosition const& chunk_pos, Chunk&& chunk, MeshMode mesh_mode, VertexFormat vertex_format );
+    bool take( ChunkPosition const& chunk_pos, CachedChunk& out_chunk );
+    void drop_mesh( ChunkPosition const& chunk_pos );
+    void erase( ChunkPosition const& chunk_pos );
+    void clear();
+
+    CacheStats stats() const;
+
+private:
+    using Entry = std::pair<std::pair<int, int>, CachedChunk>;
+
+    kl::GPU& m_gpu;
+    std::list<Entry> m_entries;
+    std::map<std::pair<int, int>, std::list<Entry>::iterator> m_lookup;
+    size_t m_resident_bytes = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_evictions = 0;
+
+    void erase( std::list<Entry>::iterator it );
+};
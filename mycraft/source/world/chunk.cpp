@@ -1,26 +1,36 @@
 #include "world/chunk.h"
 
 
-Block* Chunk::get_block( BlockIndex const& block_ind )
+static UINT quad_stride( VertexFormat vertex_format )
 {
-    if ( !block_ind.is_valid() )
-        return nullptr;
+    return vertex_format == VertexFormat::PACKED ? sizeof( PackedQuad ) : sizeof( Quad );
+}
 
-    return &blocks[block_ind.to_int()];
+// slot padding is left zeroed, which both formats draw as degenerate triangles
+static void write_quads( std::vector<Quad> const& quads, ChunkPosition const& chunk_pos, VertexFormat vertex_format, uint8_t* out_data )
+{
+    if ( vertex_format == VertexFormat::PACKED )
+    {
+        PackedQuad* packed_quads = reinterpret_cast<PackedQuad*>( out_data );
+        for ( size_t i = 0; i < quads.size(); i++ )
+            packed_quads[i] = pack_quad( quads[i], chunk_pos );
+        return;
+    }
+    memcpy( out_data, quads.data(), quads.size() * sizeof( Quad ) );
 }
 
-Block const* Chunk::get_block( BlockIndex const& block_ind ) const
+std::optional<Block> Chunk::get_block( BlockIndex const& block_ind ) const
 {
     if ( !block_ind.is_valid() )
-        return nullptr;
+        return std::nullopt;
 
-    return &blocks[block_ind.to_int()];
+    return blocks.get_block( block_ind.to_int() );
 }
 
 void Chunk::place_block( BlockIndex const& block_ind, Block block )
 {
-    if ( Block* self_block = get_block( block_ind ) )
-        *self_block = block;
+    if ( block_ind.is_valid() )
+        blocks.place_block( block_ind.to_int(), block );
 }
 
 void Chunk::remove_block( BlockIndex const& block_ind )
@@ -28,106 +38,487 @@ void Chunk::remove_block( BlockIndex const& block_ind )
     place_block( block_ind, Block::AIR );
 }
 
-void Chunk::convert( ChunkPosition const& chunk_pos, std::vector<Quad>& out_quads, BlockTest const& block_test )
+bool Chunk::section_buried( int section, BlockSnapshot const& snapshot ) const
 {
-    std::mutex lock;
-    kl::async_for( 0, (int) std::size( blocks ), [&]( int i )
+    if ( section <= 0 || section >= PaletteStorage::SECTION_COUNT - 1 )
+        return false;
+
+    for ( int i = section - 1; i <= section + 1; i++ )
     {
-        auto& block = blocks[i];
-        if ( is_block_gas( block ) )
-            return;
+        if ( blocks.section_kind( i ) != SectionKind::SOLID )
+            return false;
+    }
 
-        BlockPosition block_pos = BlockPosition::from_index( chunk_pos, BlockIndex::from_int( i ) );
-        std::vector<Quad> quads;
-        quads.reserve( 6 );
-        if ( is_block_pettle( block ) )
+    int first_layer = section * PaletteSection::HEIGHT;
+    for ( int y = first_layer; y < first_layer + PaletteSection::HEIGHT; y++ )
+    {
+        for ( int i = 0; i < CHUNK_WIDTH; i++ )
         {
-            pettle_to_quads( block_pos, block, quads, block_test );
+            BlockIndex sides[4] = {
+                { -1, y, i }, { CHUNK_WIDTH, y, i },
+                { i, y, -1 }, { i, y, CHUNK_WIDTH },
+            };
+            for ( auto& side : sides )
+            {
+                if ( !snapshot.is_solid( side ) )
+                    return false;
+            }
         }
-        else
+    }
+    return true;
+}
+
+uint64_t Chunk::active_layers( BlockSnapshot const& snapshot ) const
+{
+    uint64_t result = 0;
+    for ( int i = 0; i < PaletteStorage::SECTION_COUNT; i++ )
+    {
+        if ( blocks.section_kind( i ) != SectionKind::EMPTY && !section_buried( i, snapshot ) )
+            result |= PaletteStorage::section_layers( i );
+    }
+    return result;
+}
+
+static void per_face_to_quads( BlockSnapshot const& snapshot, ChunkPosition const& chunk_pos, uint64_t layers, BlockMasks const& masks, std::vector<Quad>& out_quads, bool parallel )
+{
+    static constexpr int layer_size = CHUNK_WIDTH * CHUNK_WIDTH;
+
+    BlockTest mask_test = [&]( BlockPosition const& block_pos )
+    {
+        return masks.is_solid( BlockIndex{ block_pos.x - chunk_pos.x, block_pos.y, block_pos.z - chunk_pos.z } );
+    };
+
+    int first_layer = std::countr_zero( layers );
+    int layer_count = CHUNK_HEIGHT - std::countl_zero( layers ) - first_layer;
+    int slab_count = parallel ? kl::clamp( kl::CPU_CORE_COUNT, 1, layer_count ) : 1;
+    std::vector<std::vector<Quad>> slab_quads( slab_count );
+    kl::async_for( 0, slab_count, [&]( int slab )
+    {
+        int slab_first = first_layer + slab * layer_count / slab_count;
+        int slab_last = first_layer + (slab + 1) * layer_count / slab_count;
+
+        auto& quads = slab_quads[slab];
+        quads.reserve( (size_t) (slab_last - slab_first) * layer_size );
+        for ( int y = slab_first; y < slab_last; y++ )
         {
-            block_to_quads( block_pos, block, quads, block_test );
+            if ( !((layers >> y) & 1) )
+                continue;
+
+            for ( int i = y * layer_size; i < (y + 1) * layer_size; i++ )
+            {
+                BlockIndex block_ind = BlockIndex::from_int( i );
+                Block block = snapshot.get( block_ind );
+                if ( is_block_gas( block ) )
+                    continue;
+
+                BlockPosition block_pos = BlockPosition::from_index( chunk_pos, block_ind );
+                if ( is_block_pettle( block ) )
+                {
+                    pettle_to_quads( block_pos, block, quads, mask_test );
+                }
+                else
+                {
+                    block_to_quads( block_pos, block, quads, mask_test );
+                }
+            }
         }
+    } );
 
-        lock.lock();
+    size_t quad_count = out_quads.size();
+    for ( auto& quads : slab_quads )
+        quad_count += quads.size();
+
+    out_quads.reserve( quad_count );
+    for ( auto& quads : slab_quads )
         out_quads.insert( out_quads.end(), quads.begin(), quads.end() );
-        lock.unlock();
-    } );
 }
 
-void Chunk::upload( ChunkPosition const& chunk_pos, kl::GPU& gpu, BlockTest const& block_test )
+void Chunk::convert( ChunkPosition const& chunk_pos, MeshMode mesh_mode, uint32_t section_mask, BlockSnapshot const& snapshot, bool parallel )
 {
-    std::vector<Quad> quads;
-    quads.reserve( std::size( blocks ) );
-    convert( chunk_pos, quads, block_test );
-    if ( quads.empty() )
+    uint64_t layers = active_layers( snapshot );
+    skipped_sections = PaletteStorage::SECTION_COUNT - std::popcount( layers ) / PaletteSection::HEIGHT;
+    for ( int section = 0; section < PaletteStorage::SECTION_COUNT; section++ )
+    {
+        if ( (section_mask >> section) & 1 )
+            section_quads[section].clear();
+    }
+    if ( section_mask == ALL_SECTIONS )
+        quads_mode = mesh_mode;
+
+    if ( !layers )
+        return;
+
+    BlockMasks masks;
+    masks.build( snapshot );
+    if ( mesh_mode != MeshMode::PER_FACE )
+        masks.build_visibility( layers, visibility_backend() );
+
+    for ( int section = 0; section < PaletteStorage::SECTION_COUNT; section++ )
+    {
+        uint64_t section_layers = layers & PaletteStorage::section_layers( section );
+        if ( !((section_mask >> section) & 1) || !section_layers )
+            continue;
+
+        auto& quads = section_quads[section];
+        if ( mesh_mode == MeshMode::GREEDY )
+        {
+            greedy_to_quads( snapshot, chunk_pos, section_layers, masks, quads, parallel );
+        }
+        else if ( mesh_mode == MeshMode::BINARY )
+        {
+            binary_to_quads( snapshot, chunk_pos, section_layers, masks, quads, parallel );
+        }
+        else
+        {
+            per_face_to_quads( snapshot, chunk_pos, section_layers, masks, quads, parallel );
+        }
+    }
+}
+
+void Chunk::build_buffer( ChunkPosition const& chunk_pos, VertexFormat vertex_format, kl::GPU& gpu, uint32_t section_mask )
+{
+    if ( section_mask != ALL_SECTIONS && buffer && patch_buffer( chunk_pos, vertex_format, gpu, section_mask ) )
+        return;
+
+    size_t quad_count = 0;
+    for ( auto& quads : section_quads )
+        quad_count += quads.size();
+
+    if ( quad_count == 0 )
     {
         buffer = {};
+        for ( auto& slot : section_slots )
+            slot = {};
         return;
     }
-    UINT byte_size = (UINT) quads.size() * sizeof( Quad );
-    buffer = gpu.create_vertex_buffer( quads.data(), byte_size );
+
+    uint32_t capacity = 0;
+    for ( int section = 0; section < PaletteStorage::SECTION_COUNT; section++ )
+    {
+        uint32_t section_count = (uint32_t) section_quads[section].size();
+        section_slots[section].offset = capacity;
+        section_slots[section].capacity = section_count + section_count / 4 + SECTION_SLACK;
+        capacity += section_slots[section].capacity;
+    }
+
+    UINT stride = quad_stride( vertex_format );
+    std::vector<uint8_t> data( (size_t) capacity * stride );
+    for ( int section = 0; section < PaletteStorage::SECTION_COUNT; section++ )
+        write_quads( section_quads[section], chunk_pos, vertex_format, data.data() + (size_t) section_slots[section].offset * stride );
+
+    dx::BufferDescriptor descriptor{};
+    descriptor.ByteWidth = (UINT) data.size();
+    descriptor.Usage = D3D11_USAGE_DEFAULT;
+    descriptor.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    dx::SubresourceDescriptor subresource_data{};
+    subresource_data.pSysMem = data.data();
+    buffer = gpu.create_buffer( &descriptor, &subresource_data );
 }
 
-ChunkGenerator::ChunkGenerator()
+bool Chunk::patch_buffer( ChunkPosition const& chunk_pos, VertexFormat vertex_format, kl::GPU& gpu, uint32_t section_mask )
 {
-    std::filesystem::create_directories( WORLD_PATH );
-    std::filesystem::create_directories( CHUNK_PATH );
+    for ( int section = 0; section < PaletteStorage::SECTION_COUNT; section++ )
+    {
+        if ( ((section_mask >> section) & 1) && section_quads[section].size() > section_slots[section].capacity )
+            return false;
+    }
+
+    UINT stride = quad_stride( vertex_format );
+    std::vector<uint8_t> data;
+    for ( int section = 0; section < PaletteStorage::SECTION_COUNT; section++ )
+    {
+        if ( !((section_mask >> section) & 1) )
+            continue;
+
+        SectionSlot const& slot = section_slots[section];
+        data.assign( (size_t) slot.capacity * stride, 0 );
+        write_quads( section_quads[section], chunk_pos, vertex_format, data.data() );
+        gpu.update_buffer( buffer, data.data(), slot.offset * stride, slot.capacity * stride );
+    }
+    return true;
 }
 
-void ChunkGenerator::generate_chunk( ChunkPosition const& chunk_pos, Chunk& out_chunk )
+void Chunk::upload( ChunkPosition const& chunk_pos, MeshMode mesh_mode, VertexFormat vertex_format, kl::GPU& gpu, BlockSnapshot const& snapshot, uint32_t section_mask )
 {
-    kl::async_for( 0, (int) std::size( out_chunk.blocks ), [&]( int i )
+    if ( quads_mode != mesh_mode )
+        section_mask = ALL_SECTIONS;
+
+    convert( chunk_pos, mesh_mode, section_mask, snapshot );
+    build_buffer( chunk_pos, vertex_format, gpu, section_mask );
+}
+
+void generate_synthetic( SyntheticTerrain terrain, Block* out_blocks )
+{
+    static constexpr int cave_count = 12;
+
+    int heights[CHUNK_WIDTH * CHUNK_WIDTH] = {};
+    for ( auto& height : heights )
+        height = terrain == SyntheticTerrain::NOISY ? kl::random::gen_int( 16, 48 ) : (terrain == SyntheticTerrain::CAVES ? 48 : 32);
+
+    for ( int i = 0; i < CHUNK_BLOCK_COUNT; i++ )
     {
         BlockIndex block_ind = BlockIndex::from_int( i );
-        out_chunk.blocks[i] = generate_block( chunk_pos, block_ind );
-    } );
+        out_blocks[i] = block_ind.y < heights[block_ind.x + block_ind.z * CHUNK_WIDTH] ? Block::STONE : Block::AIR;
+    }
+    if ( terrain != SyntheticTerrain::CAVES )
+        return;
+
+    for ( int i = 0; i < cave_count; i++ )
+    {
+        BlockIndex center{ kl::random::gen_int( CHUNK_WIDTH ), kl::random::gen_int( 4, 44 ), kl::random::gen_int( CHUNK_WIDTH ) };
+        int radius = kl::random::gen_int( 2, 6 );
+        for ( int j = 0; j < CHUNK_BLOCK_COUNT; j++ )
+        {
+            BlockIndex delta = BlockIndex::from_int( j ) - center;
+            if ( delta.x * delta.x + delta.y * delta.y + delta.z * delta.z <= radius * radius )
+                out_blocks[j] = Block::AIR;
+        }
+    }
 }
 
-void ChunkGenerator::generate_chunk_cached( ChunkPosition const& chunk_pos, Chunk& out_chunk )
+std::vector<VisibilityBenchmark> benchmark_visibility( int chunk_count, int repeats )
 {
-    if ( load_chunk( chunk_pos, out_chunk ) )
-        return;
-    generate_chunk( chunk_pos, out_chunk );
-    save_chunk( chunk_pos, out_chunk );
+    std::vector<VisibilityBenchmark> results;
+    if ( chunk_count <= 0 || repeats <= 0 )
+        return results;
+
+    VisibilityBackend old_backend = visibility_backend();
+    std::vector<Block> blocks( CHUNK_BLOCK_COUNT );
+    std::vector<Chunk> chunks( chunk_count );
+    std::vector<BlockSnapshot> snapshots( chunk_count );
+    std::vector<BlockMasks> masks( chunk_count );
+    for ( int terrain = 0; terrain < SYNTHETIC_TERRAIN_COUNT; terrain++ )
+    {
+        for ( int i = 0; i < chunk_count; i++ )
+        {
+            generate_synthetic( SyntheticTerrain( terrain ), blocks.data() );
+            chunks[i].blocks.assign( blocks.data() );
+            snapshots[i].build( chunks[i].blocks, {} );
+            masks[i].build( snapshots[i] );
+        }
+
+        for ( int backend = 0; backend < VISIBILITY_BACKEND_COUNT; backend++ )
+        {
+            if ( !visibility_supported( VisibilityBackend( backend ) ) )
+                continue;
+
+            VisibilityBenchmark result;
+            result.terrain = SyntheticTerrain( terrain );
+            result.backend = VisibilityBackend( backend );
+            result.chunk_count = chunk_count;
+
+            uint64_t start_time = kl::time::now();
+            for ( int r = 0; r < repeats; r++ )
+            {
+                for ( int i = 0; i < chunk_count; i++ )
+                    masks[i].build_visibility( ~0ull, result.backend );
+            }
+            result.kernel_rate = chunk_count * repeats / std::max( kl::time::elapsed( start_time ), 1e-6f );
+
+            set_visibility_backend( result.backend );
+            start_time = kl::time::now();
+            for ( int r = 0; r < repeats; r++ )
+            {
+                for ( int i = 0; i < chunk_count; i++ )
+                    chunks[i].convert( ChunkPosition{}, MeshMode::BINARY, Chunk::ALL_SECTIONS, snapshots[i] );
+            }
+            result.mesh_rate = chunk_count * repeats / std::max( kl::time::elapsed( start_time ), 1e-6f );
+
+            start_time = kl::time::now();
+            for ( int r = 0; r < repeats; r++ )
+            {
+                for ( int i = 0; i < chunk_count; i++ )
+                    chunks[i].convert( ChunkPosition{}, MeshMode::BINARY, Chunk::ALL_SECTIONS, snapshots[i], false );
+            }
+            result.core_rate = chunk_count * repeats / std::max( kl::time::elapsed( start_time ), 1e-6f );
+            results.push_back( result );
+        }
+    }
+    set_visibility_backend( old_backend );
+    return results;
 }
 
-Block ChunkGenerator::generate_block( ChunkPosition const& chunk_pos, BlockIndex const& block_ind )
+LoadBenchmark benchmark_world_load( std::string const& path, int chunk_count )
 {
-    switch ( block_ind.y )
+    LoadBenchmark result;
+    result.chunk_count = chunk_count;
+    if ( chunk_count <= 0 )
+        return result;
+
+    auto bench_position = []( int i )
+    {
+        return ChunkPosition{ (i % RegionFile::WIDTH) * CHUNK_WIDTH, (i / RegionFile::WIDTH) * CHUNK_WIDTH };
+    };
+
+    std::filesystem::remove_all( path );
     {
-    case 2: return Block::GRASS;
-    case 1: return Block::DIRT;
-    case 0: return Block::STONE;
-    default: return Block::AIR;
+        RegionStorage storage{ path };
+        std::vector<Block> blocks( CHUNK_BLOCK_COUNT );
+        std::vector<byte> data;
+        for ( int i = 0; i < chunk_count; i++ )
+        {
+            generate_synthetic( SyntheticTerrain::CAVES, blocks.data() );
+            data.clear();
+            encode_chunk( blocks.data(), data );
+            storage.save( bench_position( i ), data.data(), data.size() );
+        }
+    }
+
+    std::vector<Block> blocks( (size_t) CHUNK_BLOCK_COUNT * chunk_count );
+    auto load = [&]( RegionStorage& storage, int i )
+    {
+        Block* out_blocks = blocks.data() + (size_t) i * CHUNK_BLOCK_COUNT;
+        return storage.load( bench_position( i ), [out_blocks]( std::span<byte const> data )
+        {
+            return decode_chunk( data.data(), data.size(), out_blocks );
+        } );
+    };
+    {
+        RegionStorage storage{ path };
+        uint64_t start_time = kl::time::now();
+        for ( int i = 0; i < chunk_count; i++ )
+        {
+            if ( !load( storage, i ) )
+                result.failed += 1;
+        }
+        result.serial_rate = chunk_count / std::max( kl::time::elapsed( start_time ) * 1000.0f, 1e-6f );
     }
+    {
+        RegionStorage storage{ path };
+        std::atomic<int> failed = 0;
+        uint64_t start_time = kl::time::now();
+        kl::async_for( 0, chunk_count, [&]( int i )
+        {
+            if ( !load( storage, i ) )
+                failed += 1;
+        } );
+        result.parallel_rate = chunk_count / std::max( kl::time::elapsed( start_time ) * 1000.0f, 1e-6f );
+        result.failed += failed;
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all( path, error );
+    return result;
 }
 
-bool ChunkGenerator::load_chunk( ChunkPosition const& chunk_pos, Chunk& chunk )
+ChunkGenerator::ChunkGenerator()
 {
-    std::string path = make_chunk_path( chunk_pos );
+    std::filesystem::create_directories( WORLD_PATH );
+    storage.convert_chunk_files( CHUNK_PATH );
+}
 
-    kl::File file{ path, false };
-    if ( !file )
-        return false;
+void ChunkGenerator::generate_chunk( ChunkPosition const& chunk_pos, Chunk& out_chunk )
+{
+    std::vector<Block> blocks( PaletteSection::BLOCK_COUNT );
+    for ( int section = 0; section < PaletteStorage::SECTION_COUNT; section++ )
+    {
+        auto& chunk_section = out_chunk.blocks.sections[section];
+        if ( section_empty( chunk_pos, section ) )
+        {
+            chunk_section.fill( Block::AIR );
+            skipped_sections += 1;
+            continue;
+        }
 
-    size_t block_count = std::size( chunk.blocks );
-    return file.read<Block>( chunk.blocks, block_count ) == block_count;
+        int first_index = section * PaletteSection::BLOCK_COUNT;
+        kl::async_for( 0, PaletteSection::BLOCK_COUNT, [&]( int i )
+        {
+            BlockIndex block_ind = BlockIndex::from_int( first_index + i );
+            blocks[i] = generate_block( chunk_pos, block_ind );
+        } );
+        chunk_section.assign( blocks.data() );
+        generated_sections += 1;
+    }
 }
 
-bool ChunkGenerator::save_chunk( ChunkPosition const& chunk_pos, Chunk const& chunk )
+void ChunkGenerator::generate_blocks( ChunkPosition const& chunk_pos, Block* out_blocks )
 {
-    std::string path = make_chunk_path( chunk_pos );
+    for ( int section = 0; section < PaletteStorage::SECTION_COUNT; section++ )
+    {
+        int first_index = section * PaletteSection::BLOCK_COUNT;
+        if ( section_empty( chunk_pos, section ) )
+        {
+            std::fill( out_blocks + first_index, out_blocks + first_index + PaletteSection::BLOCK_COUNT, Block::AIR );
+            continue;
+        }
+        kl::async_for( first_index, first_index + PaletteSection::BLOCK_COUNT, [&]( int i )
+        {
+            out_blocks[i] = generate_block( chunk_pos, BlockIndex::from_int( i ) );
+        } );
+    }
+}
+
+Block ChunkGenerator::generate_block( ChunkPosition const& chunk_pos, BlockIndex const& block_ind )
+{
+    if ( block_ind.y >= TERRAIN_HEIGHT )
+        return Block::AIR;
+    if ( block_ind.y == TERRAIN_HEIGHT - 1 )
+        return Block::GRASS;
+    if ( block_ind.y == 0 )
+        return Block::STONE;
+    return Block::DIRT;
+}
+
+bool ChunkGenerator::section_empty( ChunkPosition const& chunk_pos, int section ) const
+{
+    return section * PaletteSection::HEIGHT >= TERRAIN_HEIGHT;
+}
 
-    kl::File file{ path, true };
-    if ( !file )
+bool ChunkGenerator::load_chunk( ChunkPosition const& chunk_pos, Chunk& chunk )
+{
+    std::vector<Block> blocks( CHUNK_BLOCK_COUNT );
+    std::vector<byte> delta;
+    ChunkReader reader = [&]( std::span<byte const> data )
+    {
+        if ( is_delta_chunk( data.data(), data.size() ) )
+        {
+            delta.assign( data.begin(), data.end() );
+            return true;
+        }
+        return decode_chunk( data.data(), data.size(), blocks.data() );
+    };
+    if ( !storage.load( chunk_pos, reader ) )
         return false;
 
-    size_t block_count = std::size( chunk.blocks );
-    return file.write<Block>( chunk.blocks, block_count ) == block_count;
+    if ( !delta.empty() )
+    {
+        std::vector<Block> baseline( CHUNK_BLOCK_COUNT );
+        generate_blocks( chunk_pos, baseline.data() );
+        if ( !decode_chunk( delta.data(), delta.size(), blocks.data(), baseline.data() ) )
+            return false;
+    }
+    chunk.blocks.assign( blocks.data() );
+    return true;
 }
 
-std::string ChunkGenerator::make_chunk_path( ChunkPosition const& pos )
+bool ChunkGenerator::save_chunk( ChunkPosition const& chunk_pos, PaletteStorage const& blocks )
 {
-    return kl::format( CHUNK_PATH, pos.x, '_', pos.z, ".chunk" );
+    std::vector<Block> expanded( CHUNK_BLOCK_COUNT );
+    blocks.extract( expanded.data() );
+
+    std::vector<byte> data;
+    if ( save_mode == SaveMode::DELTA )
+    {
+        std::vector<Block> baseline( CHUNK_BLOCK_COUNT );
+        generate_blocks( chunk_pos, baseline.data() );
+        if ( !encode_chunk_delta( baseline.data(), expanded.data(), data ) )
+        {
+            baseline_saves += 1;
+            return storage.erase( chunk_pos );
+        }
+    }
+    else
+    {
+        encode_chunk( expanded.data(), data );
+    }
+
+    if ( is_delta_chunk( data.data(), data.size() ) )
+    {
+        delta_saves += 1;
+    }
+    else
+    {
+        snapshot_saves += 1;
+    }
+    return storage.save( chunk_pos, data.data(), data.size() );
 }
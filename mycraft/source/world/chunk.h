@@ -1,36 +1,105 @@
 #pragma once
 
-#include "world/block.h"
+#include "world/mesher.h"
+#include "world/region.h"
+#include "world/codec.h"
 
 
+struct SectionSlot
+{
+    uint32_t offset = 0;
+    uint32_t capacity = 0;
+};
+
 struct Chunk
 {
-    Block blocks[CHUNK_WIDTH * CHUNK_WIDTH * CHUNK_HEIGHT] = {};
+    static constexpr uint32_t ALL_SECTIONS = (1u << PaletteStorage::SECTION_COUNT) - 1;
+    static constexpr uint32_t SECTION_SLACK = 8;
+
+    PaletteStorage blocks;
+    std::vector<Quad> section_quads[PaletteStorage::SECTION_COUNT];
+    std::optional<MeshMode> quads_mode;
     dx::Buffer buffer;
+    SectionSlot section_slots[PaletteStorage::SECTION_COUNT];
+    int skipped_sections = 0;
+    uint64_t stream_ticket = 0;
+    uint32_t border_sections = 0;
+    std::optional<ChunkPosition> resident_pos;
 
-    Block* get_block( BlockIndex const& block_ind );
-    Block const* get_block( BlockIndex const& block_ind ) const;
+    std::optional<Block> get_block( BlockIndex const& block_ind ) const;
 
     void place_block( BlockIndex const& block_ind, Block block );
     void remove_block( BlockIndex const& block_ind );
 
-    void convert( ChunkPosition const& chunk_pos, std::vector<Quad>& out_quads, BlockTest const& block_test );
-    void upload( ChunkPosition const& chunk_pos, kl::GPU& gpu, BlockTest const& block_test );
+    bool section_buried( int section, BlockSnapshot const& snapshot ) const;
+    uint64_t active_layers( BlockSnapshot const& snapshot ) const;
+
+    void convert( ChunkPosition const& chunk_pos, MeshMode mesh_mode, uint32_t section_mask, BlockSnapshot const& snapshot, bool parallel = true );
+    void build_buffer( ChunkPosition const& chunk_pos, VertexFormat vertex_format, kl::GPU& gpu, uint32_t section_mask = ALL_SECTIONS );
+    bool patch_buffer( ChunkPosition const& chunk_pos, VertexFormat vertex_format, kl::GPU& gpu, uint32_t section_mask );
+    void upload( ChunkPosition const& chunk_pos, MeshMode mesh_mode, VertexFormat vertex_format, kl::GPU& gpu, BlockSnapshot const& snapshot, uint32_t section_mask = ALL_SECTIONS );
+};
+
+enum SyntheticTerrain : uint8_t
+{
+    FLAT = 0,
+    NOISY,
+    CAVES,
+};
+
+inline constexpr int SYNTHETIC_TERRAIN_COUNT = 3;
+
+struct VisibilityBenchmark
+{
+    SyntheticTerrain terrain = SyntheticTerrain::FLAT;
+    VisibilityBackend backend = VisibilityBackend::SCALAR;
+    int chunk_count = 0;
+    float kernel_rate = 0.0f;
+    float mesh_rate = 0.0f;
+    float core_rate = 0.0f;
+};
+
+struct LoadBenchmark
+{
+    int chunk_count = 0;
+    int failed = 0;
+    float serial_rate = 0.0f;
+    float parallel_rate = 0.0f;
+};
+
+void generate_synthetic( SyntheticTerrain terrain, Block* out_blocks );
+std::vector<VisibilityBenchmark> benchmark_visibility( int chunk_count, int repeats );
+LoadBenchmark benchmark_world_load( std::string const& path, int chunk_count );
+
+enum SaveMode : uint8_t
+{
+    SNAPSHOT = 0,
+    DELTA,
 };
 
 struct ChunkGenerator
 {
     static inline std::string WORLD_PATH = "_world/";
     static inline std::string CHUNK_PATH = WORLD_PATH + "chunks/";
+    static inline std::string REGION_PATH = WORLD_PATH + "regions/";
+
+    static constexpr int TERRAIN_HEIGHT = 3;
+
+    std::atomic<uint64_t> generated_sections = 0;
+    std::atomic<uint64_t> skipped_sections = 0;
+    std::atomic<uint64_t> snapshot_saves = 0;
+    std::atomic<uint64_t> delta_saves = 0;
+    std::atomic<uint64_t> baseline_saves = 0;
+    SaveMode save_mode = SaveMode::DELTA;
+    RegionStorage storage{ REGION_PATH };
 
     ChunkGenerator();
 
     void generate_chunk( ChunkPosition const& chunk_pos, Chunk& out_chunk );
-    void generate_chunk_cached( ChunkPosition const& chunk_pos, Chunk& out_chunk );
+    void generate_blocks( ChunkPosition const& chunk_pos, Block* out_blocks );
     Block generate_block( ChunkPosition const& chunk_pos, BlockIndex const& block_ind );
+    bool section_empty( ChunkPosition const& chunk_pos, int section ) const;
 
     bool load_chunk( ChunkPosition const& chunk_pos, Chunk& chunk );
-    bool save_chunk( ChunkPosition const& chunk_pos, Chunk const& chunk );
-
-    static std::string make_chunk_path( ChunkPosition const& position );
+    bool save_chunk( ChunkPosition const& chunk_pos, PaletteStorage const& blocks );
 };
@@ -0,0 +1,387 @@
+#include "world/codec.h"
+
+
+static constexpr int LZ_MIN_MATCH = 4;
+static constexpr int LZ_MAX_OFFSET = 0xFFFF;
+static constexpr int LZ_HASH_BITS = 12;
+
+static constexpr auto CRC32_TABLE = []
+{
+    std::array<uint32_t, 256> table = {};
+    for ( uint32_t i = 0; i < 256; i++ )
+    {
+        uint32_t value = i;
+        for ( int j = 0; j < 8; j++ )
+            value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+        table[i] = value;
+    }
+    return table;
+}();
+
+uint32_t crc32( void const* data, size_t byte_size )
+{
+    byte const* bytes = (byte const*) data;
+    uint32_t crc = 0xFFFFFFFF;
+    for ( size_t i = 0; i < byte_size; i++ )
+        crc = CRC32_TABLE[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void write_varint( uint32_t value, std::vector<byte>& out_data )
+{
+    while ( value >= 0x80 )
+    {
+        out_data.push_back( byte( value | 0x80 ) );
+        value >>= 7;
+    }
+    out_data.push_back( byte( value ) );
+}
+
+static bool read_varint( byte const* data, size_t byte_size, size_t& position, uint32_t& out_value )
+{
+    out_value = 0;
+    for ( int shift = 0; shift < 32 && position < byte_size; shift += 7 )
+    {
+        byte value = data[position++];
+        out_value |= uint32_t( value & 0x7F ) << shift;
+        if ( !(value & 0x80) )
+            return true;
+    }
+    return false;
+}
+
+void rle_encode( Block const* blocks, int block_count, std::vector<byte>& out_data )
+{
+    for ( int i = 0; i < block_count; )
+    {
+        int run = 1;
+        while ( i + run < block_count && blocks[i + run] == blocks[i] )
+            run += 1;
+
+        out_data.push_back( blocks[i] );
+        write_varint( uint32_t( run - 1 ), out_data );
+        i += run;
+    }
+}
+
+bool rle_decode( byte const* data, size_t byte_size, Block* out_blocks, int block_count )
+{
+    size_t position = 0;
+    int count = 0;
+    while ( position < byte_size )
+    {
+        Block block = Block( data[position++] );
+        uint32_t run = 0;
+        if ( !read_varint( data, byte_size, position, run ) || run >= uint32_t( block_count - count ) )
+            return false;
+
+        std::fill( out_blocks + count, out_blocks + count + run + 1, block );
+        count += int( run ) + 1;
+    }
+    return count == block_count;
+}
+
+static uint32_t read_u32( byte const* data )
+{
+    uint32_t value = 0;
+    memcpy( &value, data, sizeof( value ) );
+    return value;
+}
+
+static void write_length( size_t length, std::vector<byte>& out_data )
+{
+    while ( length >= 255 )
+    {
+        out_data.push_back( 255 );
+        length -= 255;
+    }
+    out_data.push_back( byte( length ) );
+}
+
+static bool read_length( byte const* data, size_t byte_size, size_t& position, size_t& length )
+{
+    byte value = 255;
+    while ( value == 255 )
+    {
+        if ( position >= byte_size )
+            return false;
+        value = data[position++];
+        length += value;
+    }
+    return true;
+}
+
+static void write_sequence( byte const* literals, size_t literal_count, size_t match_length, size_t offset, std::vector<byte>& out_data )
+{
+    size_t match_code = match_length ? match_length - LZ_MIN_MATCH : 0;
+    byte token = byte( (std::min<size_t>( literal_count, 15 ) << 4) | std::min<size_t>( match_code, 15 ) );
+    out_data.push_back( token );
+    if ( literal_count >= 15 )
+        write_length( literal_count - 15, out_data );
+    out_data.insert( out_data.end(), literals, literals + literal_count );
+    if ( !match_length )
+        return;
+
+    out_data.push_back( byte( offset & 0xFF ) );
+    out_data.push_back( byte( offset >> 8 ) );
+    if ( match_code >= 15 )
+        write_length( match_code - 15, out_data );
+}
+
+void lz_encode( byte const* data, size_t byte_size, std::vector<byte>& out_data )
+{
+    std::vector<int> table( (size_t) 1 << LZ_HASH_BITS, -1 );
+    auto hash = []( uint32_t value )
+    {
+        return (value * 2654435761u) >> (32 - LZ_HASH_BITS);
+    };
+
+    size_t anchor = 0;
+    size_t position = 0;
+    while ( position + LZ_MIN_MATCH <= byte_size )
+    {
+        uint32_t value = read_u32( data + position );
+        int& entry = table[hash( value )];
+        int candidate = entry;
+        entry = (int) position;
+
+        if ( candidate < 0 || position - candidate > LZ_MAX_OFFSET || read_u32( data + candidate ) != value )
+        {
+            position += 1;
+            continue;
+        }
+
+        size_t match_length = LZ_MIN_MATCH;
+        while ( position + match_length < byte_size && data[candidate + match_length] == data[position + match_length] )
+            match_length += 1;
+
+        write_sequence( data + anchor, position - anchor, match_length, position - candidate, out_data );
+        position += match_length;
+        anchor = position;
+    }
+    write_sequence( data + anchor, byte_size - anchor, 0, 0, out_data );
+}
+
+bool lz_decode( byte const* data, size_t byte_size, std::vector<byte>& out_data, size_t decoded_size )
+{
+    out_data.clear();
+    out_data.reserve( decoded_size );
+
+    size_t position = 0;
+    while ( position < byte_size )
+    {
+        byte token = data[position++];
+        size_t literal_count = token >> 4;
+        if ( literal_count == 15 && !read_length( data, byte_size, position, literal_count ) )
+            return false;
+        if ( position + literal_count > byte_size || out_data.size() + literal_count > decoded_size )
+            return false;
+
+        out_data.insert( out_data.end(), data + position, data + position + literal_count );
+        position += literal_count;
+        if ( position == byte_size )
+            break;
+
+        if ( position + 2 > byte_size )
+            return false;
+        size_t offset = data[position] | (size_t( data[position + 1] ) << 8);
+        position += 2;
+
+        size_t match_length = token & 0x0F;
+        if ( match_length == 15 && !read_length( data, byte_size, position, match_length ) )
+            return false;
+        match_length += LZ_MIN_MATCH;
+
+        if ( offset == 0 || offset > out_data.size() || out_data.size() + match_length > decoded_size )
+            return false;
+
+        size_t source = out_data.size() - offset;
+        for ( size_t i = 0; i < match_length; i++ )
+            out_data.push_back( out_data[source + i] );
+    }
+    return out_data.size() == decoded_size;
+}
+
+int delta_encode( Block const* baseline, Block const* blocks, int block_count, std::vector<byte>& out_data )
+{
+    std::vector<byte> edits;
+    int edit_count = 0;
+    int previous = -1;
+    for ( int i = 0; i < block_count; i++ )
+    {
+        if ( blocks[i] == baseline[i] )
+            continue;
+
+        write_varint( uint32_t( i - previous - 1 ), edits );
+        edits.push_back( blocks[i] );
+        edit_count += 1;
+        previous = i;
+    }
+    write_varint( uint32_t( edit_count ), out_data );
+    out_data.insert( out_data.end(), edits.begin(), edits.end() );
+    return edit_count;
+}
+
+bool delta_decode( byte const* data, size_t byte_size, Block* in_out_blocks, int block_count )
+{
+    size_t position = 0;
+    uint32_t edit_count = 0;
+    if ( !read_varint( data, byte_size, position, edit_count ) )
+        return false;
+
+    int index = -1;
+    for ( uint32_t i = 0; i < edit_count; i++ )
+    {
+        uint32_t gap = 0;
+        if ( !read_varint( data, byte_size, position, gap ) || gap >= uint32_t( block_count - index - 1 ) || position >= byte_size )
+            return false;
+
+        index += int( gap ) + 1;
+        in_out_blocks[index] = Block( data[position++] );
+    }
+    return position == byte_size;
+}
+
+void encode_chunk( Block const* blocks, std::vector<byte>& out_data )
+{
+    std::vector<byte> rle_data;
+    rle_encode( blocks, CHUNK_BLOCK_COUNT, rle_data );
+
+    ChunkCodecHeader header;
+    header.stages = CODEC_STAGE_RLE | CODEC_STAGE_LZ;
+    header.rle_size = (uint32_t) rle_data.size();
+    header.checksum = crc32( blocks, CHUNK_BLOCK_COUNT );
+
+    out_data.resize( sizeof( header ) );
+    lz_encode( rle_data.data(), rle_data.size(), out_data );
+    if ( out_data.size() > sizeof( header ) + CHUNK_BLOCK_COUNT )
+    {
+        header.stages = 0;
+        header.rle_size = CHUNK_BLOCK_COUNT;
+        out_data.resize( sizeof( header ) );
+        out_data.insert( out_data.end(), (byte const*) blocks, (byte const*) blocks + CHUNK_BLOCK_COUNT );
+    }
+    memcpy( out_data.data(), &header, sizeof( header ) );
+}
+
+int encode_chunk_delta( Block const* baseline, Block const* blocks, std::vector<byte>& out_data )
+{
+    ChunkCodecHeader header;
+    header.stages = CODEC_STAGE_DELTA;
+    header.checksum = crc32( blocks, CHUNK_BLOCK_COUNT );
+
+    out_data.resize( sizeof( header ) );
+    int edit_count = delta_encode( baseline, blocks, CHUNK_BLOCK_COUNT, out_data );
+    header.rle_size = uint32_t( out_data.size() - sizeof( header ) );
+    memcpy( out_data.data(), &header, sizeof( header ) );
+    if ( edit_count == 0 )
+        return 0;
+
+    std::vector<byte> full_data;
+    encode_chunk( blocks, full_data );
+    if ( full_data.size() < out_data.size() )
+        out_data = std::move( full_data );
+    return edit_count;
+}
+
+bool decode_chunk( byte const* data, size_t byte_size, Block* out_blocks, Block const* baseline )
+{
+    ChunkCodecHeader header;
+    if ( byte_size >= sizeof( header ) )
+        memcpy( &header, data, sizeof( header ) );
+
+    if ( byte_size < sizeof( header ) || header.magic != CHUNK_CODEC_MAGIC )
+    {
+        if ( byte_size != CHUNK_BLOCK_COUNT )
+            return false;
+
+        memcpy( out_blocks, data, CHUNK_BLOCK_COUNT );
+        return true;
+    }
+    if ( header.version > CHUNK_CODEC_VERSION || header.block_count != CHUNK_BLOCK_COUNT )
+        return false;
+
+    byte const* payload = data + sizeof( header );
+    size_t payload_size = byte_size - sizeof( header );
+
+    if ( header.stages & CODEC_STAGE_DELTA )
+    {
+        if ( !baseline )
+            return false;
+
+        memcpy( out_blocks, baseline, CHUNK_BLOCK_COUNT );
+        return delta_decode( payload, payload_size, out_blocks, CHUNK_BLOCK_COUNT ) && crc32( out_blocks, CHUNK_BLOCK_COUNT ) == header.checksum;
+    }
+
+    std::vector<byte> rle_data;
+    if ( header.stages & CODEC_STAGE_LZ )
+    {
+        if ( !lz_decode( payload, payload_size, rle_data, header.rle_size ) )
+            return false;
+
+        payload = rle_data.data();
+        payload_size = rle_data.size();
+    }
+    if ( header.stages & CODEC_STAGE_RLE )
+    {
+        if ( !rle_decode( payload, payload_size, out_blocks, CHUNK_BLOCK_COUNT ) )
+            return false;
+    }
+    else
+    {
+        if ( payload_size != CHUNK_BLOCK_COUNT )
+            return false;
+
+        memcpy( out_blocks, payload, CHUNK_BLOCK_COUNT );
+    }
+    return crc32( out_blocks, CHUNK_BLOCK_COUNT ) == header.checksum;
+}
+
+bool is_delta_chunk( byte const* data, size_t byte_size )
+{
+    ChunkCodecHeader header;
+    if ( byte_size < sizeof( header ) )
+        return false;
+
+    memcpy( &header, data, sizeof( header ) );
+    return header.magic == CHUNK_CODEC_MAGIC && (header.stages & CODEC_STAGE_DELTA);
+}
+
+CodecBenchmark benchmark_codec( std::vector<Block> const& blocks, int repeats )
+{
+    CodecBenchmark result;
+    result.chunk_count = int( blocks.size() / CHUNK_BLOCK_COUNT );
+    if ( result.chunk_count == 0 || repeats <= 0 )
+        return result;
+
+    std::vector<std::vector<byte>> encoded( result.chunk_count );
+    uint64_t encode_start = kl::time::now();
+    for ( int r = 0; r < repeats; r++ )
+    {
+        for ( int i = 0; i < result.chunk_count; i++ )
+        {
+            encoded[i].clear();
+            encode_chunk( blocks.data() + (size_t) i * CHUNK_BLOCK_COUNT, encoded[i] );
+        }
+    }
+    float encode_time = kl::time::elapsed( encode_start );
+
+    std::vector<Block> decoded( CHUNK_BLOCK_COUNT );
+    uint64_t decode_start = kl::time::now();
+    for ( int r = 0; r < repeats; r++ )
+    {
+        for ( auto& data : encoded )
+            decode_chunk( data.data(), data.size(), decoded.data() );
+    }
+    float decode_time = kl::time::elapsed( decode_start );
+
+    size_t encoded_bytes = 0;
+    for ( auto& data : encoded )
+        encoded_bytes += data.size();
+
+    float raw_megabytes = float( blocks.size() ) * repeats / (1024.0f * 1024.0f);
+    result.bytes_per_chunk = float( encoded_bytes ) / result.chunk_count;
+    result.encode_throughput = encode_time > 0.0f ? raw_megabytes / encode_time : 0.0f;
+    result.decode_throughput = decode_time > 0.0f ? raw_megabytes / decode_time : 0.0f;
+    return result;
+}
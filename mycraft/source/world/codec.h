@@ -0,0 +1,46 @@
+#pragma once
+
+#include "world/block.h"
+
+
+inline constexpr uint32_t CHUNK_CODEC_MAGIC = 0x4B48434D;
+inline constexpr uint16_t CHUNK_CODEC_VERSION = 2;
+inline constexpr uint16_t CODEC_STAGE_RLE = 1 << 0;
+inline constexpr uint16_t CODEC_STAGE_LZ = 1 << 1;
+inline constexpr uint16_t CODEC_STAGE_DELTA = 1 << 2;
+
+struct ChunkCodecHeader
+{
+    uint32_t magic = CHUNK_CODEC_MAGIC;
+    uint16_t version = CHUNK_CODEC_VERSION;
+    uint16_t stages = 0;
+    uint32_t block_count = CHUNK_BLOCK_COUNT;
+    uint32_t rle_size = 0;
+    uint32_t checksum = 0;
+};
+
+struct CodecBenchmark
+{
+    int chunk_count = 0;
+    float bytes_per_chunk = 0.0f;
+    float encode_throughput = 0.0f;
+    float decode_throughput = 0.0f;
+};
+
+uint32_t crc32( void const* data, size_t byte_size );
+
+void rle_encode( Block const* blocks, int block_count, std::vector<byte>& out_data );
+bool rle_decode( byte const* data, size_t byte_size, Block* out_blocks, int block_count );
+
+void lz_encode( byte const* data, size_t byte_size, std::vector<byte>& out_data );
+bool lz_decode( byte const* data, size_t byte_size, std::vector<byte>& out_data, size_t decoded_size );
+
+int delta_encode( Block const* baseline, Block const* blocks, int block_count, std::vector<byte>& out_data );
+bool delta_decode( byte const* data, size_t byte_size, Block* in_out_blocks, int block_count );
+
+void encode_chunk( Block const* blocks, std::vector<byte>& out_data );
+int encode_chunk_delta( Block const* baseline, Block const* blocks, std::vector<byte>& out_data );
+bool decode_chunk( byte const* data, size_t byte_size, Block* out_blocks, Block const* baseline = nullptr );
+bool is_delta_chunk( byte const* data, size_t byte_size );
+
+CodecBenchmark benchmark_codec( std::vector<Block> const& blocks, int repeats );
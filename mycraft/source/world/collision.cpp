@@ -0,0 +1,235 @@
+#include "world/collision.h"
+
+
+static constexpr float COLLISION_EPSILON = 1e-4f;
+
+struct CollisionBox
+{
+    flt3 min_point;
+    flt3 max_point;
+};
+
+static CollisionBox body_box( CollisionBody const& body )
+{
+    CollisionBox box;
+    box.min_point = body.position - flt3{ body.half_width, 0.0f, body.half_width };
+    box.max_point = body.position + flt3{ body.half_width, body.height, body.half_width };
+    return box;
+}
+
+static bool layer_blocked( CollisionBox const& box, int axis, int layer, BlockTest const& block_test )
+{
+    int a_axis = (axis + 1) % 3;
+    int b_axis = (axis + 2) % 3;
+    int first_a = (int) floor( box.min_point[a_axis] + COLLISION_EPSILON );
+    int last_a = (int) ceil( box.max_point[a_axis] - COLLISION_EPSILON ) - 1;
+    int first_b = (int) floor( box.min_point[b_axis] + COLLISION_EPSILON );
+    int last_b = (int) ceil( box.max_point[b_axis] - COLLISION_EPSILON ) - 1;
+    for ( int b = first_b; b <= last_b; b++ )
+    {
+        for ( int a = first_a; a <= last_a; a++ )
+        {
+            int cell[3] = {};
+            cell[axis] = layer;
+            cell[a_axis] = a;
+            cell[b_axis] = b;
+            if ( block_test( BlockPosition{ cell[0], cell[1], cell[2] } ) )
+                return true;
+        }
+    }
+    return false;
+}
+
+static float clip_axis( CollisionBox const& box, int axis, float delta, BlockTest const& block_test )
+{
+    if ( delta > 0.0f )
+    {
+        int first_layer = (int) ceil( box.max_point[axis] - COLLISION_EPSILON );
+        int last_layer = (int) ceil( box.max_point[axis] + delta ) - 1;
+        for ( int layer = first_layer; layer <= last_layer; layer++ )
+        {
+            if ( layer_blocked( box, axis, layer, block_test ) )
+                return std::max( layer - box.max_point[axis], 0.0f );
+        }
+    }
+    else if ( delta < 0.0f )
+    {
+        int first_layer = (int) floor( box.min_point[axis] + COLLISION_EPSILON ) - 1;
+        int last_layer = (int) floor( box.min_point[axis] + delta );
+        for ( int layer = first_layer; layer >= last_layer; layer-- )
+        {
+            if ( layer_blocked( box, axis, layer, block_test ) )
+                return std::min( layer + 1 - box.min_point[axis], 0.0f );
+        }
+    }
+    return delta;
+}
+
+static void offset_box( CollisionBox& box, int axis, float delta )
+{
+    box.min_point[axis] += delta;
+    box.max_point[axis] += delta;
+}
+
+static flt3 sweep_box( CollisionBox& box, flt3 const& delta, BlockTest const& block_test )
+{
+    static constexpr int axis_order[3] = { 1, 0, 2 };
+
+    flt3 moved;
+    for ( int axis : axis_order )
+    {
+        moved[axis] = clip_axis( box, axis, delta[axis], block_test );
+        offset_box( box, axis, moved[axis] );
+    }
+    return moved;
+}
+
+void move_body( CollisionBody& body, float delta_t, BlockTest const& block_test )
+{
+    flt3 delta = body.velocity * delta_t;
+    CollisionBox box = body_box( body );
+    CollisionBox start_box = box;
+    flt3 moved = sweep_box( box, delta, block_test );
+
+    bool landed = delta.y < 0.0f && moved.y != delta.y;
+    bool blocked_sideways = moved.x != delta.x || moved.z != delta.z;
+    if ( blocked_sideways && (body.on_ground || landed) && body.step_height > 0.0f )
+    {
+        CollisionBox step_box = start_box;
+        float raised = clip_axis( step_box, 1, body.step_height, block_test );
+        offset_box( step_box, 1, raised );
+        flt3 step_moved = sweep_box( step_box, flt3{ delta.x, 0.0f, delta.z }, block_test );
+        float lowered = clip_axis( step_box, 1, -raised, block_test );
+        offset_box( step_box, 1, lowered );
+
+        float step_distance = step_moved.x * step_moved.x + step_moved.z * step_moved.z;
+        float flat_distance = moved.x * moved.x + moved.z * moved.z;
+        if ( step_distance > flat_distance + COLLISION_EPSILON )
+        {
+            box = step_box;
+            moved = step_moved;
+            moved.y = raised + lowered;
+            delta.y = moved.y;
+            landed = lowered != -raised;
+        }
+    }
+
+    body.on_ground = landed;
+    body.hit_ceiling = delta.y > 0.0f && moved.y != delta.y;
+    if ( landed )
+        body.velocity.y = 0.0f;
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        if ( moved[axis] != delta[axis] )
+            body.velocity[axis] = 0.0f;
+    }
+    body.position += box.min_point - start_box.min_point;
+}
+
+void move_bodies( std::span<CollisionBody> bodies, float delta_t, BlockTest const& block_test )
+{
+    for ( auto& body : bodies )
+        move_body( body, delta_t, block_test );
+}
+
+static void add_blocks( std::set<std::tuple<int, int, int>>& solid, BlockPosition const& min_pos, BlockPosition const& max_pos )
+{
+    for ( int y = min_pos.y; y <= max_pos.y; y++ )
+    {
+        for ( int z = min_pos.z; z <= max_pos.z; z++ )
+        {
+            for ( int x = min_pos.x; x <= max_pos.x; x++ )
+                solid.emplace( x, y, z );
+        }
+    }
+}
+
+static CollisionBody run_body( CollisionBody body, std::set<std::tuple<int, int, int>> const& solid, float gravity, float delta_t, int steps )
+{
+    BlockTest block_test = [&]( BlockPosition const& block_pos )
+    {
+        return solid.contains( { block_pos.x, block_pos.y, block_pos.z } );
+    };
+    for ( int i = 0; i < steps; i++ )
+    {
+        body.velocity.y -= gravity * delta_t;
+        move_body( body, delta_t, block_test );
+    }
+    return body;
+}
+
+static bool near( float value, float expected )
+{
+    return abs( value - expected ) < 1e-3f;
+}
+
+CollisionCheck check_collision()
+{
+    static constexpr float gravity = 20.0f;
+    static constexpr float delta_t = 1.0f / 60.0f;
+
+    std::set<std::tuple<int, int, int>> floor;
+    add_blocks( floor, { -4, 0, -4 }, { 24, 0, 4 } );
+
+    std::set<std::tuple<int, int, int>> wall = floor;
+    add_blocks( wall, { 5, 1, -4 }, { 5, 2, 4 } );
+
+    std::set<std::tuple<int, int, int>> step = floor;
+    add_blocks( step, { 5, 1, -4 }, { 24, 1, 4 } );
+
+    std::set<std::tuple<int, int, int>> ceiling = floor;
+    add_blocks( ceiling, { -1, 3, -1 }, { 1, 3, 1 } );
+
+    std::set<std::tuple<int, int, int>> thin_wall = floor;
+    add_blocks( thin_wall, { 10, 1, -4 }, { 10, 3, 4 } );
+
+    CollisionBody standing;
+    standing.position = { 0.5f, 1.0f, 0.5f };
+    standing.step_height = 1.0f;
+    standing.on_ground = true;
+
+    CollisionCheck check;
+    auto expect = [&]( bool passed )
+    {
+        check.cases += 1;
+        if ( !passed )
+            check.failures += 1;
+    };
+
+    CollisionBody falling = standing;
+    falling.position.y = 4.0f;
+    falling.on_ground = false;
+    CollisionBody landed = run_body( falling, floor, gravity, delta_t, 60 );
+    expect( near( landed.position.y, 1.0f ) && landed.on_ground && landed.velocity.y == 0.0f );
+
+    CollisionBody walking = standing;
+    walking.velocity.x = 4.0f;
+    CollisionBody walled = run_body( walking, wall, gravity, delta_t, 120 );
+    expect( near( walled.position.x, 5.0f - walking.half_width ) && near( walled.position.y, 1.0f ) && walled.velocity.x == 0.0f );
+
+    CollisionBody stepped = run_body( walking, step, gravity, delta_t, 120 );
+    expect( stepped.position.x > 5.0f + walking.half_width && near( stepped.position.y, 2.0f ) && stepped.on_ground );
+
+    CollisionBody low_step = walking;
+    low_step.step_height = 0.6f;
+    CollisionBody blocked = run_body( low_step, step, gravity, delta_t, 120 );
+    expect( near( blocked.position.x, 5.0f - low_step.half_width ) && near( blocked.position.y, 1.0f ) );
+
+    CollisionBody jumping = standing;
+    jumping.velocity.y = 8.0f;
+    CollisionBody bumped = run_body( jumping, ceiling, 0.0f, delta_t, 2 );
+    expect( near( bumped.position.y, 3.0f - jumping.height ) && bumped.velocity.y == 0.0f && bumped.hit_ceiling );
+
+    CollisionBody dropping = falling;
+    dropping.position.y = 30.0f;
+    dropping.velocity.y = -2000.0f;
+    CollisionBody caught = run_body( dropping, floor, 0.0f, delta_t, 1 );
+    expect( near( caught.position.y, 1.0f ) && caught.on_ground );
+
+    CollisionBody rushing = standing;
+    rushing.velocity.x = 3000.0f;
+    CollisionBody stopped = run_body( rushing, thin_wall, 0.0f, delta_t, 1 );
+    expect( near( stopped.position.x, 10.0f - rushing.half_width ) && stopped.velocity.x == 0.0f );
+
+    return check;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "world/block.h"
+
+
+struct CollisionBody
+{
+    flt3 position;
+    flt3 velocity;
+    float half_width = 0.3f;
+    float height = 1.8f;
+    float step_height = 0.6f;
+    bool on_ground = false;
+    bool hit_ceiling = false;
+};
+
+struct CollisionCheck
+{
+    int cases = 0;
+    int failures = 0;
+};
+
+void move_body( CollisionBody& body, float delta_t, BlockTest const& block_test );
+void move_bodies( std::span<CollisionBody> bodies, float delta_t, BlockTest const& block_test );
+CollisionCheck check_collision();
@@ -0,0 +1,94 @@
+#include "world/journal.h"
+
+
+static_assert( sizeof( JournalRecord ) == 16, "Journal records are stored as raw 16 byte entries" );
+
+static uint32_t record_checksum( JournalRecord const& record )
+{
+    return crc32( &record, offsetof( JournalRecord, checksum ) );
+}
+
+SaveJournal::SaveJournal( std::string const& path )
+    : m_path( path )
+{
+    m_record_count = read().size();
+    m_file.open( m_path, true, false );
+    m_file.unwind();
+}
+
+bool SaveJournal::append( ChunkPosition const& chunk_pos, BlockIndex const& block_ind, Block block )
+{
+    JournalRecord record;
+    record.chunk_x = chunk_pos.x;
+    record.chunk_z = chunk_pos.z;
+    record.block_index = (uint16_t) block_ind.to_int();
+    record.block = block;
+    record.checksum = record_checksum( record );
+    if ( m_file.write( record ) != 1 || !m_file.flush() )
+        return false;
+
+    m_record_count += 1;
+    return true;
+}
+
+std::vector<JournalRecord> SaveJournal::read() const
+{
+    std::vector<JournalRecord> records;
+    kl::File file{ m_path, false };
+    JournalRecord record;
+    while ( file.read( record ) == 1 && record.checksum == record_checksum( record ) && record.block_index < CHUNK_BLOCK_COUNT )
+        records.push_back( record );
+    return records;
+}
+
+bool SaveJournal::checkpoint()
+{
+    std::string temp_path = m_path + ".tmp";
+    m_file.close();
+    bool created = (bool) kl::File{ temp_path, true };
+
+    std::error_code error;
+    if ( created )
+        std::filesystem::rename( temp_path, m_path, error );
+
+    m_file.open( m_path, true, false );
+    m_file.unwind();
+    if ( !created || error )
+        return false;
+
+    m_record_count = 0;
+    return true;
+}
+
+uint64_t SaveJournal::record_count() const
+{
+    return m_record_count;
+}
+
+JournalBenchmark benchmark_journal( std::string const& path, int edit_count )
+{
+    JournalBenchmark result;
+    result.edit_count = edit_count;
+    {
+        SaveJournal journal{ path };
+        uint64_t start_time = kl::time::now();
+        for ( int i = 0; i < edit_count; i++ )
+        {
+            ChunkPosition chunk_pos{ (i % 32) * CHUNK_WIDTH, (i / 32 % 32) * CHUNK_WIDTH };
+            journal.append( chunk_pos, BlockIndex::from_int( i % CHUNK_BLOCK_COUNT ), Block::STONE );
+        }
+        float append_time = kl::time::elapsed( start_time );
+
+        start_time = kl::time::now();
+        journal.checkpoint();
+        result.checkpoint_time = kl::time::elapsed( start_time );
+
+        if ( edit_count > 0 && append_time > 0.0f )
+        {
+            result.append_time = append_time / edit_count;
+            result.edits_per_ms = edit_count / (append_time * 1000.0f);
+        }
+    }
+    std::filesystem::remove( path );
+    return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "world/codec.h"
+
+
+struct JournalRecord
+{
+    int32_t chunk_x = 0;
+    int32_t chunk_z = 0;
+    uint16_t block_index = 0;
+    Block block = Block::AIR;
+    uint8_t reserved = 0;
+    uint32_t checksum = 0;
+};
+
+struct JournalBenchmark
+{
+    int edit_count = 0;
+    float append_time = 0.0f;
+    float edits_per_ms = 0.0f;
+    float checkpoint_time = 0.0f;
+};
+
+struct SaveJournal
+{
+    SaveJournal( std::string const& path );
+
+    // Records are flushed to the OS, not to the disk, so they survive a process crash but not a power loss.
+    bool append( ChunkPosition const& chunk_pos, BlockIndex const& block_ind, Block block );
+    std::vector<JournalRecord> read() const;
+    bool checkpoint();
+
+    uint64_t record_count() const;
+
+private:
+    std::string m_path;
+    kl::File m_file;
+    uint64_t m_record_count = 0;
+};
+
+JournalBenchmark benchmark_journal( std::string const& path, int edit_count );
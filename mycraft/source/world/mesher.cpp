@@ -0,0 +1,259 @@
+#include "world/mesher.h"
+
+
+static_assert( CHUNK_HEIGHT == 64, "Block masks store one chunk column per 64 bit word" );
+
+static constexpr int CHUNK_DIMS[3] = { CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_WIDTH };
+
+void BlockMasks::build( BlockSnapshot const& snapshot )
+{
+    for ( int z = -BORDER; z < CHUNK_WIDTH + BORDER; z++ )
+    {
+        for ( int x = -BORDER; x < CHUNK_WIDTH + BORDER; x++ )
+        {
+            uint64_t mask = 0;
+            for ( int y = 0; y < CHUNK_HEIGHT; y++ )
+                mask |= uint64_t( snapshot.is_solid( { x, y, z } ) ) << y;
+            columns[(x + BORDER) + (z + BORDER) * WIDTH] = mask;
+        }
+    }
+}
+
+uint64_t BlockMasks::column( int x, int z ) const
+{
+    x += BORDER;
+    z += BORDER;
+    if ( x < 0 || z < 0 || x >= WIDTH || z >= WIDTH )
+        return 0;
+    return columns[x + z * WIDTH];
+}
+
+bool BlockMasks::is_solid( BlockIndex const& block_ind ) const
+{
+    if ( block_ind.y < 0 || block_ind.y >= CHUNK_HEIGHT )
+        return false;
+    return (column( block_ind.x, block_ind.z ) >> block_ind.y) & 1;
+}
+
+void BlockMasks::build_visibility( uint64_t active_layers, VisibilityBackend backend )
+{
+    compute_visibility( columns + BORDER + BORDER * WIDTH, WIDTH, active_layers, backend, visibility );
+}
+
+uint64_t BlockMasks::visible_faces( int face, int x, int z ) const
+{
+    return visibility.faces[face][x + z * CHUNK_WIDTH];
+}
+
+void BlockMasks::face_ambient( BlockIndex const& block_ind, int face, byte( &out_ambient )[4] ) const
+{
+    int ring = 0;
+    for ( int i = 0; i < 8; i++ )
+    {
+        BlockPosition offset = face_ring_offset( face, i );
+        if ( is_solid( block_ind + BlockIndex{ offset.x, offset.y, offset.z } ) )
+            ring |= 1 << i;
+    }
+    ring_ambient( face, ring, out_ambient );
+}
+
+static constexpr uint64_t make_face_key( Block block, byte const( &ambient )[4] )
+{
+    uint64_t key = block;
+    for ( int i = 0; i < 4; i++ )
+        key |= uint64_t( ambient[i] ) << (8 + i * 8);
+    return key | (1ull << 40);
+}
+
+static constexpr Block key_block( uint64_t key )
+{
+    return Block( key & 0xFF );
+}
+
+static constexpr byte key_ambient( uint64_t key, int corner )
+{
+    return byte( (key >> (8 + corner * 8)) & 0xFF );
+}
+
+static void pettles_to_quads( BlockSnapshot const& snapshot, ChunkPosition const& chunk_pos, uint64_t active_layers, BlockMasks const& masks, std::vector<Quad>& out_quads )
+{
+    static constexpr int layer_size = CHUNK_WIDTH * CHUNK_WIDTH;
+
+    BlockTest mask_test = [&]( BlockPosition const& block_pos )
+    {
+        return masks.is_solid( BlockIndex{ block_pos.x - chunk_pos.x, block_pos.y, block_pos.z - chunk_pos.z } );
+    };
+    for ( int y = 0; y < CHUNK_HEIGHT; y++ )
+    {
+        if ( !((active_layers >> y) & 1) )
+            continue;
+
+        for ( int i = y * layer_size; i < (y + 1) * layer_size; i++ )
+        {
+            BlockIndex block_ind = BlockIndex::from_int( i );
+            Block block = snapshot.get( block_ind );
+            if ( !is_block_pettle( block ) )
+                continue;
+
+            pettle_to_quads( BlockPosition::from_index( chunk_pos, block_ind ), block, out_quads, mask_test );
+        }
+    }
+}
+
+static void binary_face_to_quads( BlockSnapshot const& snapshot, ChunkPosition const& chunk_pos, uint64_t active_layers, BlockMasks const& masks, int face, std::vector<Quad>& out_quads )
+{
+    static constexpr BlockPosition unit_size{ 1, 1, 1 };
+    for ( int z = 0; z < CHUNK_WIDTH; z++ )
+    {
+        for ( int x = 0; x < CHUNK_WIDTH; x++ )
+        {
+            uint64_t visible = masks.visible_faces( face, x, z ) & active_layers;
+            while ( visible )
+            {
+                int y = std::countr_zero( visible );
+                visible &= visible - 1;
+
+                BlockIndex block_ind{ x, y, z };
+                byte ambient[4] = {};
+                masks.face_ambient( block_ind, face, ambient );
+
+                Quad quad;
+                face_to_quad( BlockPosition::from_index( chunk_pos, block_ind ), unit_size, face, snapshot.get( block_ind ), ambient, quad );
+                out_quads.push_back( quad );
+            }
+        }
+    }
+}
+
+static void greedy_face_to_quads( BlockSnapshot const& snapshot, ChunkPosition const& chunk_pos, uint64_t active_layers, BlockMasks const& masks, int face, std::vector<Quad>& out_quads )
+{
+    BlockPosition normal = face_normal( face );
+    int n_axis = normal.x != 0 ? 0 : (normal.y != 0 ? 1 : 2);
+    int a_axis = (n_axis + 1) % 3;
+    int b_axis = (n_axis + 2) % 3;
+    int a_dim = CHUNK_DIMS[a_axis];
+    int b_dim = CHUNK_DIMS[b_axis];
+
+    uint64_t visible[CHUNK_WIDTH * CHUNK_WIDTH] = {};
+    for ( int z = 0; z < CHUNK_WIDTH; z++ )
+    {
+        for ( int x = 0; x < CHUNK_WIDTH; x++ )
+            visible[x + z * CHUNK_WIDTH] = masks.visible_faces( face, x, z ) & active_layers;
+    }
+
+    std::vector<uint64_t> mask( (size_t) a_dim * b_dim );
+    for ( int n = 0; n < CHUNK_DIMS[n_axis]; n++ )
+    {
+        if ( n_axis == 1 && !((active_layers >> n) & 1) )
+            continue;
+
+        int coords[3] = {};
+        coords[n_axis] = n;
+        for ( int b = 0; b < b_dim; b++ )
+        {
+            coords[b_axis] = b;
+            for ( int a = 0; a < a_dim; a++ )
+            {
+                coords[a_axis] = a;
+                BlockIndex block_ind{ coords[0], coords[1], coords[2] };
+
+                uint64_t key = 0;
+                if ( (visible[block_ind.x + block_ind.z * CHUNK_WIDTH] >> block_ind.y) & 1 )
+                {
+                    byte ambient[4] = {};
+                    masks.face_ambient( block_ind, face, ambient );
+                    key = make_face_key( snapshot.get( block_ind ), ambient );
+                }
+                mask[a + b * a_dim] = key;
+            }
+        }
+
+        for ( int b = 0; b < b_dim; b++ )
+        {
+            for ( int a = 0; a < a_dim; a++ )
+            {
+                uint64_t key = mask[a + b * a_dim];
+                if ( !key )
+                    continue;
+
+                int width = 1;
+                while ( a + width < a_dim && width < MAX_TILING && mask[a + width + b * a_dim] == key )
+                    width += 1;
+
+                int height = 1;
+                for ( ; b + height < b_dim && height < MAX_TILING; height++ )
+                {
+                    bool row_matches = true;
+                    for ( int i = 0; i < width; i++ )
+                    {
+                        if ( mask[a + i + (b + height) * a_dim] != key )
+                        {
+                            row_matches = false;
+                            break;
+                        }
+                    }
+                    if ( !row_matches )
+                        break;
+                }
+
+                for ( int j = 0; j < height; j++ )
+                {
+                    for ( int i = 0; i < width; i++ )
+                        mask[a + i + (b + j) * a_dim] = 0;
+                }
+
+                coords[a_axis] = a;
+                coords[b_axis] = b;
+                int size[3] = {};
+                size[n_axis] = 1;
+                size[a_axis] = width;
+                size[b_axis] = height;
+
+                byte ambient[4] = {};
+                for ( int i = 0; i < 4; i++ )
+                    ambient[i] = key_ambient( key, i );
+
+                BlockPosition block_pos = BlockPosition::from_index( chunk_pos, BlockIndex{ coords[0], coords[1], coords[2] } );
+                Quad quad;
+                face_to_quad( block_pos, BlockPosition{ size[0], size[1], size[2] }, face, key_block( key ), ambient, quad );
+                out_quads.push_back( quad );
+
+                a += width - 1;
+            }
+        }
+    }
+}
+
+void binary_to_quads( BlockSnapshot const& snapshot, ChunkPosition const& chunk_pos, uint64_t active_layers, BlockMasks const& masks, std::vector<Quad>& out_quads, bool parallel )
+{
+    std::vector<Quad> face_quads[BLOCK_FACE_COUNT];
+    auto mesh_face = [&]( int face )
+    {
+        binary_face_to_quads( snapshot, chunk_pos, active_layers, masks, face, face_quads[face] );
+    };
+    if ( parallel )
+        kl::async_for( 0, BLOCK_FACE_COUNT, mesh_face );
+    else
+        kl::sync_for( 0, BLOCK_FACE_COUNT, mesh_face );
+    for ( auto& quads : face_quads )
+        out_quads.insert( out_quads.end(), quads.begin(), quads.end() );
+
+    pettles_to_quads( snapshot, chunk_pos, active_layers, masks, out_quads );
+}
+
+void greedy_to_quads( BlockSnapshot const& snapshot, ChunkPosition const& chunk_pos, uint64_t active_layers, BlockMasks const& masks, std::vector<Quad>& out_quads, bool parallel )
+{
+    std::vector<Quad> face_quads[BLOCK_FACE_COUNT];
+    auto mesh_face = [&]( int face )
+    {
+        greedy_face_to_quads( snapshot, chunk_pos, active_layers, masks, face, face_quads[face] );
+    };
+    if ( parallel )
+        kl::async_for( 0, BLOCK_FACE_COUNT, mesh_face );
+    else
+        kl::sync_for( 0, BLOCK_FACE_COUNT, mesh_face );
+    for ( auto& quads : face_quads )
+        out_quads.insert( out_quads.end(), quads.begin(), quads.end() );
+
+    pettles_to_quads( snapshot, chunk_pos, active_layers, masks, out_quads );
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "world/snapshot.h"
+#include "world/visibility.h"
+
+
+enum MeshMode : uint8_t
+{
+    PER_FACE = 0,
+    GREEDY,
+    BINARY,
+};
+
+inline constexpr int MESH_MODE_COUNT = 3;
+
+struct BlockMasks
+{
+    static constexpr int BORDER = BlockSnapshot::BORDER;
+    static constexpr int WIDTH = BlockSnapshot::WIDTH;
+
+    uint64_t columns[WIDTH * WIDTH] = {};
+    FaceVisibility visibility;
+
+    void build( BlockSnapshot const& snapshot );
+    void build_visibility( uint64_t active_layers, VisibilityBackend backend );
+
+    uint64_t column( int x, int z ) const;
+    bool is_solid( BlockIndex const& block_ind ) const;
+
+    uint64_t visible_faces( int face, int x, int z ) const;
+    void face_ambient( BlockIndex const& block_ind, int face, byte( &out_ambient )[4] ) const;
+};
+
+void binary_to_quads( BlockSnapshot const& snapshot, ChunkPosition const& chunk_pos, uint64_t active_layers, BlockMasks const& masks, std::vector<Quad>& out_quads, bool parallel = true );
+void greedy_to_quads( BlockSnapshot const& snapshot, ChunkPosition const& chunk_pos, uint64_t active_layers, BlockMasks const& masks, std::vector<Quad>& out_quads, bool parallel = true );
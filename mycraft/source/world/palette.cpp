@@ -0,0 +1,216 @@
+#include "world/palette.h"
+
+
+static_assert( CHUNK_HEIGHT % PaletteSection::HEIGHT == 0, "Chunk height must be a multiple of the section height" );
+
+PaletteSection::PaletteSection()
+{
+    fill( Block::AIR );
+}
+
+Block PaletteSection::get_block( int index ) const
+{
+    return m_palette[palette_index( index )];
+}
+
+void PaletteSection::place_block( int index, Block block )
+{
+    int new_index = -1;
+    for ( int i = 0; i < (int) m_palette.size(); i++ )
+    {
+        if ( m_palette[i] == block )
+        {
+            new_index = i;
+            break;
+        }
+    }
+    if ( new_index < 0 )
+    {
+        new_index = (int) m_palette.size();
+        m_palette.push_back( block );
+        int bits = bits_for( (int) m_palette.size() );
+        if ( bits != m_bits )
+            resize_bits( bits );
+        update_kind();
+    }
+    if ( m_bits > 0 )
+        set_palette_index( index, new_index );
+}
+
+void PaletteSection::fill( Block block )
+{
+    m_palette.assign( 1, block );
+    m_data = {};
+    m_bits = 0;
+    update_kind();
+}
+
+void PaletteSection::assign( Block const* blocks )
+{
+    int lookup[256];
+    std::fill( std::begin( lookup ), std::end( lookup ), -1 );
+
+    m_palette.clear();
+    for ( int i = 0; i < BLOCK_COUNT; i++ )
+    {
+        int& entry = lookup[blocks[i]];
+        if ( entry < 0 )
+        {
+            entry = (int) m_palette.size();
+            m_palette.push_back( blocks[i] );
+        }
+    }
+    m_palette.shrink_to_fit();
+    update_kind();
+
+    m_bits = bits_for( (int) m_palette.size() );
+    m_data.assign( (size_t) BLOCK_COUNT * m_bits / 64, 0 );
+    m_data.shrink_to_fit();
+    if ( m_bits == 0 )
+        return;
+
+    for ( int i = 0; i < BLOCK_COUNT; i++ )
+        set_palette_index( i, lookup[blocks[i]] );
+}
+
+void PaletteSection::extract( Block* out_blocks ) const
+{
+    if ( m_bits == 0 )
+    {
+        std::fill( out_blocks, out_blocks + BLOCK_COUNT, m_palette.front() );
+        return;
+    }
+    int per_word = 64 / m_bits;
+    uint64_t mask = (1ull << m_bits) - 1;
+    for ( int w = 0; w < (int) m_data.size(); w++ )
+    {
+        uint64_t word = m_data[w];
+        for ( int i = 0; i < per_word; i++ )
+        {
+            out_blocks[w * per_word + i] = m_palette[word & mask];
+            word >>= m_bits;
+        }
+    }
+}
+
+SectionKind PaletteSection::kind() const
+{
+    return m_kind;
+}
+
+bool PaletteSection::is_uniform() const
+{
+    return m_bits == 0;
+}
+
+int PaletteSection::bits_per_block() const
+{
+    return m_bits;
+}
+
+int PaletteSection::palette_size() const
+{
+    return (int) m_palette.size();
+}
+
+size_t PaletteSection::byte_size() const
+{
+    return sizeof( PaletteSection ) + m_palette.capacity() * sizeof( Block ) + m_data.capacity() * sizeof( uint64_t );
+}
+
+int PaletteSection::palette_index( int index ) const
+{
+    if ( m_bits == 0 )
+        return 0;
+
+    int per_word = 64 / m_bits;
+    int shift = (index % per_word) * m_bits;
+    return int( (m_data[index / per_word] >> shift) & ((1ull << m_bits) - 1) );
+}
+
+void PaletteSection::set_palette_index( int index, int palette_index )
+{
+    int per_word = 64 / m_bits;
+    int shift = (index % per_word) * m_bits;
+    uint64_t mask = ((1ull << m_bits) - 1) << shift;
+    uint64_t& word = m_data[index / per_word];
+    word = (word & ~mask) | (uint64_t( palette_index ) << shift);
+}
+
+void PaletteSection::resize_bits( int bits )
+{
+    std::vector<int> indices( BLOCK_COUNT );
+    for ( int i = 0; i < BLOCK_COUNT; i++ )
+        indices[i] = palette_index( i );
+
+    m_bits = bits;
+    m_data.assign( (size_t) BLOCK_COUNT * m_bits / 64, 0 );
+    for ( int i = 0; i < BLOCK_COUNT; i++ )
+        set_palette_index( i, indices[i] );
+}
+
+void PaletteSection::update_kind()
+{
+    bool all_gas = true;
+    bool all_solid = true;
+    for ( Block block : m_palette )
+    {
+        all_gas = all_gas && is_block_gas( block );
+        all_solid = all_solid && is_block_solid( block );
+    }
+    m_kind = all_gas ? SectionKind::EMPTY : (all_solid ? SectionKind::SOLID : SectionKind::MIXED);
+}
+
+int PaletteSection::bits_for( int palette_size )
+{
+    if ( palette_size <= 1 )
+        return 0;
+    if ( palette_size <= 2 )
+        return 1;
+    if ( palette_size <= 4 )
+        return 2;
+    if ( palette_size <= 16 )
+        return 4;
+    return 8;
+}
+
+Block PaletteStorage::get_block( int index ) const
+{
+    return sections[index / PaletteSection::BLOCK_COUNT].get_block( index % PaletteSection::BLOCK_COUNT );
+}
+
+void PaletteStorage::place_block( int index, Block block )
+{
+    sections[index / PaletteSection::BLOCK_COUNT].place_block( index % PaletteSection::BLOCK_COUNT, block );
+}
+
+void PaletteStorage::fill( Block block )
+{
+    for ( auto& section : sections )
+        section.fill( block );
+}
+
+void PaletteStorage::assign( Block const* blocks )
+{
+    for ( int i = 0; i < SECTION_COUNT; i++ )
+        sections[i].assign( blocks + i * PaletteSection::BLOCK_COUNT );
+}
+
+void PaletteStorage::extract( Block* out_blocks ) const
+{
+    for ( int i = 0; i < SECTION_COUNT; i++ )
+        sections[i].extract( out_blocks + i * PaletteSection::BLOCK_COUNT );
+}
+
+SectionKind PaletteStorage::section_kind( int section ) const
+{
+    return sections[section].kind();
+}
+
+size_t PaletteStorage::byte_size() const
+{
+    size_t result = 0;
+    for ( auto& section : sections )
+        result += section.byte_size();
+    return result;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "world/block.h"
+
+
+enum SectionKind : uint8_t
+{
+    EMPTY = 0,
+    SOLID,
+    MIXED,
+};
+
+struct PaletteSection
+{
+    static constexpr int HEIGHT = 16;
+    static constexpr int BLOCK_COUNT = CHUNK_WIDTH * CHUNK_WIDTH * HEIGHT;
+
+    PaletteSection();
+
+    Block get_block( int index ) const;
+    void place_block( int index, Block block );
+
+    void fill( Block block );
+    void assign( Block const* blocks );
+    void extract( Block* out_blocks ) const;
+
+    SectionKind kind() const;
+    bool is_uniform() const;
+    int bits_per_block() const;
+    int palette_size() const;
+    size_t byte_size() const;
+
+private:
+    std::vector<Block> m_palette;
+    std::vector<uint64_t> m_data;
+    int m_bits = 0;
+    SectionKind m_kind = SectionKind::EMPTY;
+
+    int palette_index( int index ) const;
+    void set_palette_index( int index, int palette_index );
+    void resize_bits( int bits );
+    void update_kind();
+
+    static int bits_for( int palette_size );
+};
+
+struct PaletteStorage
+{
+    static constexpr int SECTION_COUNT = CHUNK_HEIGHT / PaletteSection::HEIGHT;
+
+    PaletteSection sections[SECTION_COUNT] = {};
+
+    Block get_block( int index ) const;
+    void place_block( int index, Block block );
+
+    void fill( Block block );
+    void assign( Block const* blocks );
+    void extract( Block* out_blocks ) const;
+
+    SectionKind section_kind( int section ) const;
+    size_t byte_size() const;
+
+    static constexpr uint64_t section_layers( int section )
+    {
+        return ((1ull << PaletteSection::HEIGHT) - 1) << (section * PaletteSection::HEIGHT);
+    }
+};
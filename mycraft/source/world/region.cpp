@@ -0,0 +1,269 @@
+#include "world/region.h"
+
+
+static int floor_div( int value, int divisor )
+{
+    return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+}
+
+RegionFile::RegionFile( std::string const& path )
+    : m_path( path )
+    , m_file( path, true, false )
+{
+    m_used.assign( HEADER_SECTORS, true );
+    if ( !m_file )
+        return;
+
+    m_file.unwind();
+    if ( m_file.tell() < HEADER_SECTORS * SECTOR_SIZE )
+    {
+        m_file.rewind();
+        m_file.write<uint32_t>( m_entries, CHUNK_COUNT );
+        m_file.flush();
+        return;
+    }
+
+    m_file.rewind();
+    m_file.read<uint32_t>( m_entries, CHUNK_COUNT );
+    for ( uint32_t entry : m_entries )
+        mark( entry, true );
+}
+
+bool RegionFile::read_chunk( int index, ChunkReader const& reader )
+{
+    std::shared_lock lock( m_mutex );
+    std::span<byte const> sectors = view_chunk( index, lock );
+    if ( sectors.size() < sizeof( uint32_t ) )
+        return false;
+
+    uint32_t byte_size = 0;
+    memcpy( &byte_size, sectors.data(), sizeof( byte_size ) );
+    if ( sizeof( uint32_t ) + byte_size > sectors.size() )
+        return false;
+
+    return reader( sectors.subspan( sizeof( uint32_t ), byte_size ) );
+}
+
+bool RegionFile::write_chunk( int index, byte const* data, size_t byte_size )
+{
+    int sector_count = int( (sizeof( uint32_t ) + byte_size + SECTOR_SIZE - 1) / SECTOR_SIZE );
+    if ( sector_count > MAX_CHUNK_SECTORS )
+        return false;
+
+    std::lock_guard lock( m_mutex );
+    if ( !m_file )
+        return false;
+
+    uint32_t old_entry = m_entries[index];
+    uint32_t entry = (uint32_t( find_free( sector_count ) ) << 8) | uint32_t( sector_count );
+    mark( entry, true );
+
+    std::vector<byte> sectors( (size_t) sector_count * SECTOR_SIZE );
+    uint32_t size_value = (uint32_t) byte_size;
+    memcpy( sectors.data(), &size_value, sizeof( size_value ) );
+    memcpy( sectors.data() + sizeof( size_value ), data, byte_size );
+
+    bool written = m_file.seek( (int64_t) entry_offset( entry ) * SECTOR_SIZE )
+        && m_file.write<byte>( sectors.data(), sectors.size() ) == sectors.size()
+        && m_file.flush();
+    if ( !written )
+    {
+        mark( entry, false );
+        return false;
+    }
+
+    m_entries[index] = entry;
+    if ( !m_file.seek( (int64_t) index * sizeof( uint32_t ) ) || m_file.write( entry ) != 1 || !m_file.flush() )
+        return false;
+
+    mark( old_entry, false );
+    return true;
+}
+
+bool RegionFile::erase_chunk( int index )
+{
+    std::lock_guard lock( m_mutex );
+    uint32_t old_entry = m_entries[index];
+    if ( !old_entry )
+        return true;
+
+    m_entries[index] = 0;
+    uint32_t entry = 0;
+    if ( !m_file.seek( (int64_t) index * sizeof( uint32_t ) ) || m_file.write( entry ) != 1 || !m_file.flush() )
+        return false;
+
+    mark( old_entry, false );
+    return true;
+}
+
+void RegionFile::prefetch_chunk( int index )
+{
+    std::shared_lock lock( m_mutex );
+    if ( view_chunk( index, lock ).empty() )
+        return;
+
+    uint32_t entry = m_entries[index];
+    m_mapped.prefetch( (uint64_t) entry_offset( entry ) * SECTOR_SIZE, (uint64_t) entry_count( entry ) * SECTOR_SIZE );
+}
+
+int RegionFile::used_sectors() const
+{
+    std::shared_lock lock( m_mutex );
+    return (int) std::count( m_used.begin(), m_used.end(), true );
+}
+
+std::span<byte const> RegionFile::view_chunk( int index, std::shared_lock<std::shared_mutex>& lock )
+{
+    std::span<byte const> sectors = view_sectors( m_entries[index] );
+    if ( !sectors.empty() || !m_entries[index] )
+        return sectors;
+
+    lock.unlock();
+    {
+        std::lock_guard remap_lock( m_mutex );
+        uint32_t entry = m_entries[index];
+        if ( entry && view_sectors( entry ).empty() )
+            m_mapped.open( m_path );
+    }
+    lock.lock();
+    return view_sectors( m_entries[index] );
+}
+
+std::span<byte const> RegionFile::view_sectors( uint32_t entry ) const
+{
+    if ( !entry )
+        return {};
+
+    uint64_t offset = (uint64_t) entry_offset( entry ) * SECTOR_SIZE;
+    uint64_t size = (uint64_t) entry_count( entry ) * SECTOR_SIZE;
+    std::span<byte const> sectors = m_mapped.view( offset, size );
+    return sectors.size() == size ? sectors : std::span<byte const>{};
+}
+
+int RegionFile::find_free( int sector_count ) const
+{
+    int run = 0;
+    for ( int i = HEADER_SECTORS; i < (int) m_used.size(); i++ )
+    {
+        run = m_used[i] ? 0 : run + 1;
+        if ( run == sector_count )
+            return i - sector_count + 1;
+    }
+    return (int) m_used.size() - run;
+}
+
+void RegionFile::mark( uint32_t entry, bool used )
+{
+    if ( !entry )
+        return;
+
+    int end = entry_offset( entry ) + entry_count( entry );
+    if ( end > (int) m_used.size() )
+        m_used.resize( end, false );
+    for ( int i = entry_offset( entry ); i < end; i++ )
+        m_used[i] = used;
+}
+
+RegionStorage::RegionStorage( std::string const& path )
+    : m_path( path )
+{
+    std::filesystem::create_directories( m_path );
+}
+
+bool RegionStorage::load( ChunkPosition const& chunk_pos, ChunkReader const& reader )
+{
+    int index = 0;
+    RegionFile& region = get_region( chunk_pos, index );
+    return region.read_chunk( index, reader );
+}
+
+bool RegionStorage::save( ChunkPosition const& chunk_pos, byte const* data, size_t byte_size )
+{
+    int index = 0;
+    RegionFile& region = get_region( chunk_pos, index );
+    return region.write_chunk( index, data, byte_size );
+}
+
+bool RegionStorage::erase( ChunkPosition const& chunk_pos )
+{
+    int index = 0;
+    RegionFile& region = get_region( chunk_pos, index );
+    return region.erase_chunk( index );
+}
+
+void RegionStorage::prefetch( ChunkPosition const& chunk_pos )
+{
+    int index = 0;
+    RegionFile& region = get_region( chunk_pos, index );
+    region.prefetch_chunk( index );
+}
+
+size_t RegionStorage::used_bytes()
+{
+    std::lock_guard lock( m_mutex );
+    size_t result = 0;
+    for ( auto& [_, region] : m_regions )
+        result += (size_t) region->used_sectors() * RegionFile::SECTOR_SIZE;
+    return result;
+}
+
+int RegionStorage::convert_chunk_files( std::string const& chunk_path )
+{
+    if ( !std::filesystem::exists( chunk_path ) )
+        return 0;
+
+    int converted = 0;
+    for ( auto& file_path : kl::list_files( chunk_path ) )
+    {
+        std::filesystem::path path = file_path;
+        if ( path.extension() != ".chunk" )
+            continue;
+
+        std::string stem = path.stem().string();
+        size_t separator = stem.find( '_', 1 );
+        if ( separator == std::string::npos )
+            continue;
+
+        ChunkPosition chunk_pos;
+        auto x_result = std::from_chars( stem.data(), stem.data() + separator, chunk_pos.x );
+        auto z_result = std::from_chars( stem.data() + separator + 1, stem.data() + stem.size(), chunk_pos.z );
+        if ( x_result.ec != std::errc{} || z_result.ec != std::errc{} )
+            continue;
+
+        std::vector<byte> data( CHUNK_BLOCK_COUNT );
+        {
+            kl::File file{ file_path, false };
+            if ( !file || file.read<byte>( data.data(), data.size() ) != data.size() )
+                continue;
+        }
+        if ( !save( chunk_pos, data.data(), data.size() ) )
+            continue;
+
+        std::filesystem::remove( path );
+        converted += 1;
+    }
+
+    std::error_code error;
+    if ( std::filesystem::is_empty( chunk_path, error ) )
+        std::filesystem::remove( chunk_path, error );
+    return converted;
+}
+
+std::string RegionStorage::make_region_path( int region_x, int region_z ) const
+{
+    return kl::format( m_path, region_x, '_', region_z, ".region" );
+}
+
+RegionFile& RegionStorage::get_region( ChunkPosition const& chunk_pos, int& out_index )
+{
+    ChunkIndex chunk_ind = chunk_pos.to_index();
+    int region_x = floor_div( chunk_ind.x, RegionFile::WIDTH );
+    int region_z = floor_div( chunk_ind.z, RegionFile::WIDTH );
+    out_index = (chunk_ind.x - region_x * RegionFile::WIDTH) + (chunk_ind.z - region_z * RegionFile::WIDTH) * RegionFile::WIDTH;
+
+    std::lock_guard lock( m_mutex );
+    auto& region = m_regions[{ region_x, region_z }];
+    if ( !region )
+        region = std::make_unique<RegionFile>( make_region_path( region_x, region_z ) );
+    return *region;
+}
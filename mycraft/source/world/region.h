@@ -0,0 +1,70 @@
+#pragma once
+
+#include "world/palette.h"
+
+
+using ChunkReader = std::function<bool( std::span<byte const> )>;
+
+struct RegionFile
+{
+    static constexpr int WIDTH = 32;
+    static constexpr int CHUNK_COUNT = WIDTH * WIDTH;
+    static constexpr int SECTOR_SIZE = 1024;
+    static constexpr int HEADER_SECTORS = CHUNK_COUNT * sizeof( uint32_t ) / SECTOR_SIZE;
+    static constexpr int MAX_CHUNK_SECTORS = 255;
+
+    RegionFile( std::string const& path );
+
+    bool read_chunk( int index, ChunkReader const& reader );
+    bool write_chunk( int index, byte const* data, size_t byte_size );
+    bool erase_chunk( int index );
+    void prefetch_chunk( int index );
+
+    int used_sectors() const;
+
+private:
+    std::string m_path;
+    kl::File m_file;
+    kl::MappedFile m_mapped;
+    mutable std::shared_mutex m_mutex;
+    uint32_t m_entries[CHUNK_COUNT] = {};
+    std::vector<bool> m_used;
+
+    std::span<byte const> view_chunk( int index, std::shared_lock<std::shared_mutex>& lock );
+    std::span<byte const> view_sectors( uint32_t entry ) const;
+    int find_free( int sector_count ) const;
+    void mark( uint32_t entry, bool used );
+
+    static constexpr int entry_offset( uint32_t entry )
+    {
+        return int( entry >> 8 );
+    }
+
+    static constexpr int entry_count( uint32_t entry )
+    {
+        return int( entry & 0xFF );
+    }
+};
+
+struct RegionStorage
+{
+    RegionStorage( std::string const& path );
+
+    bool load( ChunkPosition const& chunk_pos, ChunkReader const& reader );
+    bool save( ChunkPosition const& chunk_pos, byte const* data, size_t byte_size );
+    bool erase( ChunkPosition const& chunk_pos );
+    void prefetch( ChunkPosition const& chunk_pos );
+
+    size_t used_bytes();
+
+    int convert_chunk_files( std::string const& chunk_path );
+
+    std::string make_region_path( int region_x, int region_z ) const;
+
+private:
+    std::string m_path;
+    std::mutex m_mutex;
+    std::map<std::pair<int, int>, std::unique_ptr<RegionFile>> m_regions;
+
+    RegionFile& get_region( ChunkPosition const& chunk_pos, int& out_index );
+};
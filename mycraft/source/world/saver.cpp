@@ -0,0 +1,207 @@
+#include "world/saver.h"
+
+
+ChunkSaver::ChunkSaver( ChunkGenerator& generator )
+    : m_generator( generator )
+    , m_journal( ChunkGenerator::WORLD_PATH + "journal.wal" )
+{
+    m_replayed = replay_journal();
+    m_worker = std::jthread( [this]( std::stop_token stop_token ) { work( stop_token ); } );
+}
+
+void ChunkSaver::mark_dirty( ChunkPosition const& chunk_pos, PaletteStorage const& blocks )
+{
+    std::lock_guard lock( m_mutex );
+    mark_locked( chunk_pos, blocks );
+}
+
+void ChunkSaver::record_edit( ChunkPosition const& chunk_pos, BlockIndex const& block_ind, Block block, PaletteStorage const& blocks )
+{
+    std::lock_guard journal_lock( m_journal_mutex );
+    m_journal.append( chunk_pos, block_ind, block );
+    std::lock_guard lock( m_mutex );
+    mark_locked( chunk_pos, blocks );
+}
+
+void ChunkSaver::mark_locked( ChunkPosition const& chunk_pos, PaletteStorage const& blocks )
+{
+    auto [it, inserted] = m_pending.try_emplace( std::pair{ chunk_pos.x, chunk_pos.z } );
+    PendingSave& save = it->second;
+    if ( inserted )
+    {
+        save.dirty_time = kl::time::now();
+    }
+    else
+    {
+        m_coalesced += 1;
+    }
+    save.blocks = blocks;
+    save.version = m_next_version++;
+    m_marked += 1;
+}
+
+bool ChunkSaver::load_pending( ChunkPosition const& chunk_pos, PaletteStorage& out_blocks ) const
+{
+    std::lock_guard lock( m_mutex );
+    auto it = m_pending.find( { chunk_pos.x, chunk_pos.z } );
+    if ( it == m_pending.end() )
+        return false;
+
+    out_blocks = it->second.blocks;
+    return true;
+}
+
+void ChunkSaver::flush()
+{
+    std::unique_lock lock( m_mutex );
+    m_flush_requested = true;
+    m_condition.notify_all();
+    m_idle_condition.wait( lock, [this] { return attempted(); } );
+    m_flush_requested = false;
+}
+
+SaveStats ChunkSaver::stats() const
+{
+    uint64_t journaled = 0;
+    {
+        std::lock_guard journal_lock( m_journal_mutex );
+        journaled = m_journal.record_count();
+    }
+
+    std::lock_guard lock( m_mutex );
+    SaveStats stats;
+    stats.pending = (int) m_pending.size();
+    stats.marked = m_marked;
+    stats.coalesced = m_coalesced;
+    stats.written = m_written;
+    stats.failed = m_failed;
+    stats.journaled = journaled;
+    stats.checkpoints = m_checkpoints;
+    stats.replayed = m_replayed;
+    stats.max_flush_latency = m_max_flush;
+    if ( m_written + m_failed > 0 )
+    {
+        stats.write_latency = float( m_write_total / (m_written + m_failed) );
+        stats.flush_latency = float( m_flush_total / (m_written + m_failed) );
+    }
+    return stats;
+}
+
+void ChunkSaver::work( std::stop_token stop_token )
+{
+    std::unique_lock lock( m_mutex );
+    while ( true )
+    {
+        bool draining = m_flush_requested || stop_token.stop_requested();
+        auto due = std::find_if( m_pending.begin(), m_pending.end(), [&]( auto const& entry )
+        {
+            return due_in( entry.second, draining ) <= 0.0f;
+        } );
+        if ( due == m_pending.end() )
+        {
+            if ( stop_token.stop_requested() )
+                return;
+
+            m_condition.wait_for( lock, stop_token, std::chrono::duration<float>( next_due() ), [this] { return m_flush_requested && !attempted(); } );
+            continue;
+        }
+
+        std::pair<int, int> key = due->first;
+        PendingSave save = due->second;
+        lock.unlock();
+
+        uint64_t start_time = kl::time::now();
+        bool saved = m_generator.save_chunk( ChunkPosition{ key.first, key.second }, save.blocks );
+        float write_time = kl::time::elapsed( start_time );
+
+        lock.lock();
+        auto it = m_pending.find( key );
+        if ( !saved )
+        {
+            it->second.failed_time = kl::time::now();
+            it->second.failures += 1;
+        }
+        else if ( it->second.version == save.version )
+        {
+            m_pending.erase( it );
+        }
+
+        float flush_time = kl::time::elapsed( save.dirty_time );
+        m_write_total += write_time;
+        m_flush_total += flush_time;
+        m_max_flush = std::max( m_max_flush, flush_time );
+        if ( saved )
+        {
+            m_written += 1;
+        }
+        else
+        {
+            m_failed += 1;
+        }
+        if ( m_pending.empty() )
+        {
+            lock.unlock();
+            checkpoint();
+            lock.lock();
+        }
+        m_idle_condition.notify_all();
+    }
+}
+
+void ChunkSaver::checkpoint()
+{
+    std::lock_guard journal_lock( m_journal_mutex );
+    {
+        std::lock_guard lock( m_mutex );
+        if ( !m_pending.empty() )
+            return;
+    }
+    if ( m_journal.record_count() == 0 || !m_journal.checkpoint() )
+        return;
+
+    std::lock_guard lock( m_mutex );
+    m_checkpoints += 1;
+}
+
+int ChunkSaver::replay_journal()
+{
+    std::vector<JournalRecord> records = m_journal.read();
+    std::map<std::pair<int, int>, Chunk> chunks;
+    for ( auto& record : records )
+    {
+        ChunkPosition chunk_pos{ record.chunk_x, record.chunk_z };
+        auto [it, inserted] = chunks.try_emplace( std::pair{ chunk_pos.x, chunk_pos.z } );
+        if ( inserted && !m_generator.load_chunk( chunk_pos, it->second ) )
+            m_generator.generate_chunk( chunk_pos, it->second );
+        it->second.place_block( BlockIndex::from_int( record.block_index ), record.block );
+    }
+
+    bool saved = true;
+    for ( auto& [key, chunk] : chunks )
+        saved = m_generator.save_chunk( ChunkPosition{ key.first, key.second }, chunk.blocks ) && saved;
+    if ( saved && m_journal.checkpoint() )
+        m_checkpoints += 1;
+    return (int) records.size();
+}
+
+bool ChunkSaver::attempted() const
+{
+    return std::all_of( m_pending.begin(), m_pending.end(), []( auto const& entry ) { return entry.second.failures > 0; } );
+}
+
+float ChunkSaver::due_in( PendingSave const& save, bool draining ) const
+{
+    if ( save.failures == 0 )
+        return draining ? 0.0f : flush_delay - kl::time::elapsed( save.dirty_time );
+
+    float backoff = std::min( retry_delay * float( 1 << std::min( save.failures - 1, 16 ) ), max_retry_delay );
+    return backoff - kl::time::elapsed( save.failed_time );
+}
+
+float ChunkSaver::next_due() const
+{
+    float result = flush_delay;
+    for ( auto& [_, save] : m_pending )
+        result = std::min( result, due_in( save, false ) );
+    return std::max( result, 0.0f );
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "world/chunk.h"
+#include "world/journal.h"
+
+
+struct PendingSave
+{
+    PaletteStorage blocks;
+    uint64_t dirty_time = 0;
+    uint64_t version = 0;
+    uint64_t failed_time = 0;
+    int failures = 0;
+};
+
+struct SaveStats
+{
+    int pending = 0;
+    uint64_t marked = 0;
+    uint64_t coalesced = 0;
+    uint64_t written = 0;
+    uint64_t failed = 0;
+    uint64_t journaled = 0;
+    uint64_t checkpoints = 0;
+    int replayed = 0;
+    float write_latency = 0.0f;
+    float flush_latency = 0.0f;
+    float max_flush_latency = 0.0f;
+};
+
+struct ChunkSaver
+{
+    float flush_delay = 1.0f;
+    float retry_delay = 0.5f;
+    float max_retry_delay = 30.0f;
+
+    ChunkSaver( ChunkGenerator& generator );
+
+    void mark_dirty( ChunkPosition const& chunk_pos, PaletteStorage const& blocks );
+    void record_edit( ChunkPosition const& chunk_pos, BlockIndex const& block_ind, Block block, PaletteStorage const& blocks );
+    bool load_pending( ChunkPosition const& chunk_pos, PaletteStorage& out_blocks ) const;
+    void flush();
+
+    SaveStats stats() const;
+
+private:
+    ChunkGenerator& m_generator;
+    SaveJournal m_journal;
+    mutable std::mutex m_journal_mutex;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+    std::condition_variable_any m_idle_condition;
+    std::map<std::pair<int, int>, PendingSave> m_pending;
+    uint64_t m_next_version = 1;
+    bool m_flush_requested = false;
+
+    uint64_t m_marked = 0;
+    uint64_t m_coalesced = 0;
+    uint64_t m_written = 0;
+    uint64_t m_failed = 0;
+    uint64_t m_checkpoints = 0;
+    int m_replayed = 0;
+    double m_write_total = 0.0;
+    double m_flush_total = 0.0;
+    float m_max_flush = 0.0f;
+
+    std::jthread m_worker;
+
+    void mark_locked( ChunkPosition const& chunk_pos, PaletteStorage const& blocks );
+    int replay_journal();
+    void work( std::stop_token stop_token );
+    void checkpoint();
+    bool attempted() const;
+    float due_in( PendingSave const& save, bool draining ) const;
+    float next_due() const;
+};
@@ -0,0 +1,78 @@
+#include "world/snapshot.h"
+
+
+void BlockSnapshot::build( PaletteStorage const& center, ChunkNeighbours const& neighbours )
+{
+    std::fill( blocks.begin(), blocks.end(), Block::AIR );
+    copy_center( center );
+    for ( int dz = -1; dz <= 1; dz++ )
+    {
+        for ( int dx = -1; dx <= 1; dx++ )
+        {
+            PaletteStorage const* storage = neighbours[(dx + 1) + (dz + 1) * 3];
+            if ( (dx == 0 && dz == 0) || !storage )
+                continue;
+
+            int first_x = dx < 0 ? CHUNK_WIDTH - BORDER : 0;
+            int last_x = dx > 0 ? BORDER : CHUNK_WIDTH;
+            int first_z = dz < 0 ? CHUNK_WIDTH - BORDER : 0;
+            int last_z = dz > 0 ? BORDER : CHUNK_WIDTH;
+            for ( int y = 0; y < CHUNK_HEIGHT; y++ )
+            {
+                for ( int z = first_z; z < last_z; z++ )
+                {
+                    for ( int x = first_x; x < last_x; x++ )
+                    {
+                        BlockIndex local_ind{ x, y, z };
+                        blocks[index( { x + dx * CHUNK_WIDTH, y, z + dz * CHUNK_WIDTH } )] = storage->get_block( local_ind.to_int() );
+                    }
+                }
+            }
+        }
+    }
+}
+
+void BlockSnapshot::build( ChunkPosition const& chunk_pos, PaletteStorage const& center, BlockTest const& block_test )
+{
+    std::fill( blocks.begin(), blocks.end(), Block::AIR );
+    copy_center( center );
+    for ( int y = 0; y < CHUNK_HEIGHT; y++ )
+    {
+        for ( int z = -BORDER; z < CHUNK_WIDTH + BORDER; z++ )
+        {
+            for ( int x = -BORDER; x < CHUNK_WIDTH + BORDER; x++ )
+            {
+                BlockIndex block_ind{ x, y, z };
+                if ( block_ind.is_valid() )
+                    continue;
+
+                if ( block_test( BlockPosition::from_index( chunk_pos, block_ind ) ) )
+                    blocks[index( block_ind )] = Block::STONE;
+            }
+        }
+    }
+}
+
+Block BlockSnapshot::get( BlockIndex const& block_ind ) const
+{
+    return contains( block_ind ) ? blocks[index( block_ind )] : Block::AIR;
+}
+
+bool BlockSnapshot::is_solid( BlockIndex const& block_ind ) const
+{
+    return is_block_solid( get( block_ind ) );
+}
+
+void BlockSnapshot::copy_center( PaletteStorage const& center )
+{
+    std::vector<Block> expanded( CHUNK_BLOCK_COUNT );
+    center.extract( expanded.data() );
+    for ( int y = 0; y < CHUNK_HEIGHT; y++ )
+    {
+        for ( int z = 0; z < CHUNK_WIDTH; z++ )
+        {
+            Block const* row = expanded.data() + BlockIndex{ 0, y, z }.to_int();
+            std::copy( row, row + CHUNK_WIDTH, blocks.begin() + index( { 0, y, z } ) );
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "world/palette.h"
+
+
+using ChunkNeighbours = std::array<PaletteStorage const*, 9>;
+
+struct BlockSnapshot
+{
+    static constexpr int BORDER = 1;
+    static constexpr int WIDTH = CHUNK_WIDTH + BORDER * 2;
+    static constexpr int HEIGHT = CHUNK_HEIGHT + BORDER * 2;
+    static constexpr int BLOCK_COUNT = WIDTH * WIDTH * HEIGHT;
+
+    std::vector<Block> blocks = std::vector<Block>( BLOCK_COUNT, Block::AIR );
+
+    void build( PaletteStorage const& center, ChunkNeighbours const& neighbours );
+    void build( ChunkPosition const& chunk_pos, PaletteStorage const& center, BlockTest const& block_test );
+
+    Block get( BlockIndex const& block_ind ) const;
+    bool is_solid( BlockIndex const& block_ind ) const;
+
+    static constexpr bool contains( BlockIndex const& block_ind )
+    {
+        return block_ind.x >= -BORDER && block_ind.x < CHUNK_WIDTH + BORDER
+            && block_ind.y >= -BORDER && block_ind.y < CHUNK_HEIGHT + BORDER
+            && block_ind.z >= -BORDER && block_ind.z < CHUNK_WIDTH + BORDER;
+    }
+
+    static constexpr int index( BlockIndex const& block_ind )
+    {
+        return (block_ind.x + BORDER) + (block_ind.z + BORDER) * WIDTH + (block_ind.y + BORDER) * WIDTH * WIDTH;
+    }
+
+private:
+    void copy_center( PaletteStorage const& center );
+};
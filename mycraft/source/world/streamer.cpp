@@ -0,0 +1,193 @@
+#include "world/streamer.h"
+
+
+bool StreamFocus::contains( ChunkPosition const& chunk_pos ) const
+{
+    return (chunk_pos - first_chunk_pos).to_index().is_valid( width_chunks );
+}
+
+float StreamFocus::priority( ChunkPosition const& chunk_pos ) const
+{
+    static constexpr flt3 half_chunk{ CHUNK_WIDTH * 0.5f, 0.0f, CHUNK_WIDTH * 0.5f };
+    flt3 offset = chunk_pos.to_flt3() + half_chunk - flt3{ center.x, 0.0f, center.z };
+    float distance = offset.length() / CHUNK_WIDTH;
+    if ( distance < 1.0f )
+        return distance;
+
+    flt3 view{ forward.x, 0.0f, forward.z };
+    float alignment = view.length() > 0.0f ? kl::dot( offset / (distance * CHUNK_WIDTH), kl::normalize( view ) ) : 0.0f;
+    return distance * (1.0f - ChunkStreamer::VIEW_WEIGHT * alignment);
+}
+
+ChunkStreamer::ChunkStreamer( ChunkGenerator& generator, ChunkSaver& saver, kl::GPU& gpu )
+    : m_generator( generator )
+    , m_saver( saver )
+    , m_gpu( gpu )
+{
+    int worker_count = std::max( kl::CPU_CORE_COUNT - 1, 1 );
+    for ( int i = 0; i < worker_count; i++ )
+        m_workers.emplace_back( [this]( std::stop_token stop_token ) { work( stop_token ); } );
+}
+
+uint64_t ChunkStreamer::submit( ChunkPosition const& chunk_pos, MeshMode mesh_mode, VertexFormat vertex_format )
+{
+    StreamRequest request;
+    request.chunk_pos = chunk_pos;
+    request.mesh_mode = mesh_mode;
+    request.vertex_format = vertex_format;
+    request.submit_time = kl::time::now();
+    m_generator.storage.prefetch( chunk_pos );
+    {
+        std::lock_guard lock( m_mutex );
+        request.ticket = m_next_ticket++;
+        m_requests.push_back( request );
+    }
+    m_condition.notify_one();
+    return request.ticket;
+}
+
+void ChunkStreamer::clear()
+{
+    std::lock_guard lock( m_mutex );
+    m_discarded += m_requests.size() + m_results.size();
+    m_requests.clear();
+    m_results.clear();
+}
+
+void ChunkStreamer::set_focus( StreamFocus const& focus )
+{
+    std::lock_guard lock( m_mutex );
+    bool moved = focus.first_chunk_pos != m_focus.first_chunk_pos || focus.width_chunks != m_focus.width_chunks;
+    m_focus = focus;
+    if ( !moved )
+        return;
+
+    size_t count = m_requests.size();
+    std::erase_if( m_requests, [&]( StreamRequest const& request )
+    {
+        return !m_focus.contains( request.chunk_pos );
+    } );
+    m_cancelled += count - m_requests.size();
+}
+
+bool ChunkStreamer::pop_result( StreamResult& out_result )
+{
+    std::lock_guard lock( m_mutex );
+    if ( m_results.empty() )
+        return false;
+
+    out_result = std::move( m_results.front() );
+    m_results.pop_front();
+    m_integrate_total += kl::time::elapsed( out_result.complete_time );
+    return true;
+}
+
+void ChunkStreamer::finish( bool integrated )
+{
+    std::lock_guard lock( m_mutex );
+    if ( integrated )
+    {
+        m_integrated += 1;
+    }
+    else
+    {
+        m_discarded += 1;
+    }
+}
+
+StreamStats ChunkStreamer::stats() const
+{
+    std::lock_guard lock( m_mutex );
+    StreamStats stats;
+    stats.queued = (int) m_requests.size();
+    stats.in_flight = m_in_flight;
+    stats.completed = (int) m_results.size();
+    stats.integrated = m_integrated;
+    stats.discarded = m_discarded;
+    stats.cancelled = m_cancelled;
+    if ( m_processed > 0 )
+    {
+        stats.queue_latency = float( m_queue_total / m_processed );
+        stats.generate_latency = float( m_generate_total / m_processed );
+        stats.mesh_latency = float( m_mesh_total / m_processed );
+    }
+    if ( m_integrated + m_discarded > 0 )
+        stats.integrate_latency = float( m_integrate_total / (m_integrated + m_discarded) );
+    return stats;
+}
+
+void ChunkStreamer::work( std::stop_token stop_token )
+{
+    while ( true )
+    {
+        StreamResult result;
+        {
+            std::unique_lock lock( m_mutex );
+            if ( !m_condition.wait( lock, stop_token, [this] { return !m_requests.empty(); } ) )
+                return;
+
+            result.request = pop_request();
+            m_in_flight += 1;
+        }
+        StreamRequest const& request = result.request;
+
+        uint64_t start_time = kl::time::now();
+        result.queue_time = kl::time::elapsed( request.submit_time, start_time );
+
+        load_or_generate( request.chunk_pos, result.chunk );
+        uint64_t generate_time = kl::time::now();
+        result.generate_time = kl::time::elapsed( start_time, generate_time );
+        {
+            std::lock_guard lock( m_mutex );
+            if ( !m_focus.contains( request.chunk_pos ) )
+            {
+                m_in_flight -= 1;
+                m_cancelled += 1;
+                continue;
+            }
+        }
+
+        BlockSnapshot snapshot;
+        snapshot.build( result.chunk.blocks, {} );
+        result.chunk.upload( request.chunk_pos, request.mesh_mode, request.vertex_format, m_gpu, snapshot );
+        result.complete_time = kl::time::now();
+        result.mesh_time = kl::time::elapsed( generate_time, result.complete_time );
+
+        std::lock_guard lock( m_mutex );
+        m_in_flight -= 1;
+        m_processed += 1;
+        m_queue_total += result.queue_time;
+        m_generate_total += result.generate_time;
+        m_mesh_total += result.mesh_time;
+        m_results.push_back( std::move( result ) );
+    }
+}
+
+void ChunkStreamer::load_or_generate( ChunkPosition const& chunk_pos, Chunk& out_chunk )
+{
+    if ( m_saver.load_pending( chunk_pos, out_chunk.blocks ) || m_generator.load_chunk( chunk_pos, out_chunk ) )
+        return;
+
+    m_generator.generate_chunk( chunk_pos, out_chunk );
+    if ( m_generator.save_mode == SaveMode::SNAPSHOT )
+        m_saver.mark_dirty( chunk_pos, out_chunk.blocks );
+}
+
+StreamRequest ChunkStreamer::pop_request()
+{
+    int best_index = 0;
+    float best_priority = m_focus.priority( m_requests.front().chunk_pos );
+    for ( int i = 1; i < (int) m_requests.size(); i++ )
+    {
+        float priority = m_focus.priority( m_requests[i].chunk_pos );
+        if ( priority < best_priority )
+        {
+            best_priority = priority;
+            best_index = i;
+        }
+    }
+    StreamRequest request = m_requests[best_index];
+    m_requests[best_index] = m_requests.back();
+    m_requests.pop_back();
+    return request;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "world/saver.h"
+
+
+struct StreamRequest
+{
+    ChunkPosition chunk_pos;
+    uint64_t ticket = 0;
+    MeshMode mesh_mode = MeshMode::GREEDY;
+    VertexFormat vertex_format = VertexFormat::FULL;
+    uint64_t submit_time = 0;
+};
+
+struct StreamResult
+{
+    StreamRequest request;
+    Chunk chunk;
+    float queue_time = 0.0f;
+    float generate_time = 0.0f;
+    float mesh_time = 0.0f;
+    uint64_t complete_time = 0;
+};
+
+struct StreamFocus
+{
+    ChunkPosition first_chunk_pos;
+    int width_chunks = 0;
+    flt3 center;
+    flt3 forward = { 0.0f, 0.0f, 1.0f };
+
+    bool contains( ChunkPosition const& chunk_pos ) const;
+    float priority( ChunkPosition const& chunk_pos ) const;
+};
+
+struct StreamStats
+{
+    int queued = 0;
+    int in_flight = 0;
+    int completed = 0;
+    uint64_t integrated = 0;
+    uint64_t discarded = 0;
+    uint64_t cancelled = 0;
+    float queue_latency = 0.0f;
+    float generate_latency = 0.0f;
+    float mesh_latency = 0.0f;
+    float integrate_latency = 0.0f;
+};
+
+struct ChunkStreamer
+{
+    static constexpr float VIEW_WEIGHT = 0.5f;
+
+    float frame_budget = 0.002f;
+
+    ChunkStreamer( ChunkGenerator& generator, ChunkSaver& saver, kl::GPU& gpu );
+
+    uint64_t submit( ChunkPosition const& chunk_pos, MeshMode mesh_mode, VertexFormat vertex_format );
+    void clear();
+    void set_focus( StreamFocus const& focus );
+
+    bool pop_result( StreamResult& out_result );
+    void finish( bool integrated );
+
+    StreamStats stats() const;
+
+private:
+    ChunkGenerator& m_generator;
+    ChunkSaver& m_saver;
+    kl::GPU& m_gpu;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+    std::vector<StreamRequest> m_requests;
+    std::deque<StreamResult> m_results;
+    StreamFocus m_focus;
+    uint64_t m_next_ticket = 1;
+    int m_in_flight = 0;
+
+    uint64_t m_processed = 0;
+    uint64_t m_integrated = 0;
+    uint64_t m_discarded = 0;
+    uint64_t m_cancelled = 0;
+    double m_queue_total = 0.0;
+    double m_generate_total = 0.0;
+    double m_mesh_total = 0.0;
+    double m_integrate_total = 0.0;
+
+    std::vector<std::jthread> m_workers;
+
+    void work( std::stop_token stop_token );
+    void load_or_generate( ChunkPosition const& chunk_pos, Chunk& out_chunk );
+    StreamRequest pop_request();
+};
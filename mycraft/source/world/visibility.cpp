@@ -0,0 +1,138 @@
+#include "world/visibility.h"
+
+#include <intrin.h>
+
+
+static bool cpu_has_avx2()
+{
+    int info[4] = {};
+    __cpuid( info, 0 );
+    if ( info[0] < 7 )
+        return false;
+
+    __cpuid( info, 1 );
+    bool os_saves_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+    if ( !os_saves_avx || (_xgetbv( 0 ) & 0x6) != 0x6 )
+        return false;
+
+    __cpuidex( info, 7, 0 );
+    return info[1] & (1 << 5);
+}
+
+static const bool AVX2_SUPPORTED = cpu_has_avx2();
+
+static std::atomic<VisibilityBackend> active_backend = AVX2_SUPPORTED ? VisibilityBackend::AVX2 : VisibilityBackend::SSE2;
+
+bool visibility_supported( VisibilityBackend backend )
+{
+    return backend != VisibilityBackend::AVX2 || AVX2_SUPPORTED;
+}
+
+VisibilityBackend visibility_backend()
+{
+    return active_backend;
+}
+
+void set_visibility_backend( VisibilityBackend backend )
+{
+    if ( visibility_supported( backend ) )
+        active_backend = backend;
+}
+
+static void visibility_scalar( uint64_t const* columns, int row_stride, uint64_t active_layers, FaceVisibility& out_visibility )
+{
+    for ( int face = 0; face < BLOCK_FACE_COUNT; face++ )
+    {
+        BlockPosition normal = face_normal( face );
+        int neighbour_offset = normal.x + normal.z * row_stride;
+        for ( int z = 0; z < CHUNK_WIDTH; z++ )
+        {
+            uint64_t const* row = columns + z * row_stride;
+            uint64_t* out_row = out_visibility.faces[face] + z * CHUNK_WIDTH;
+            for ( int x = 0; x < CHUNK_WIDTH; x++ )
+            {
+                uint64_t self = row[x];
+                uint64_t covered = normal.y > 0 ? self >> 1 : (normal.y < 0 ? self << 1 : row[x + neighbour_offset]);
+                out_row[x] = self & ~covered & active_layers;
+            }
+        }
+    }
+}
+
+static void visibility_sse2( uint64_t const* columns, int row_stride, uint64_t active_layers, FaceVisibility& out_visibility )
+{
+    __m128i active = _mm_set1_epi64x( (long long) active_layers );
+    for ( int face = 0; face < BLOCK_FACE_COUNT; face++ )
+    {
+        BlockPosition normal = face_normal( face );
+        int neighbour_offset = normal.x + normal.z * row_stride;
+        for ( int z = 0; z < CHUNK_WIDTH; z++ )
+        {
+            uint64_t const* row = columns + z * row_stride;
+            uint64_t* out_row = out_visibility.faces[face] + z * CHUNK_WIDTH;
+            for ( int x = 0; x < CHUNK_WIDTH; x += 2 )
+            {
+                __m128i self = _mm_loadu_si128( (__m128i const*) (row + x) );
+                __m128i covered;
+                if ( normal.y > 0 )
+                {
+                    covered = _mm_srli_epi64( self, 1 );
+                }
+                else if ( normal.y < 0 )
+                {
+                    covered = _mm_slli_epi64( self, 1 );
+                }
+                else
+                {
+                    covered = _mm_loadu_si128( (__m128i const*) (row + x + neighbour_offset) );
+                }
+                __m128i visible = _mm_and_si128( _mm_andnot_si128( covered, self ), active );
+                _mm_storeu_si128( (__m128i*) (out_row + x), visible );
+            }
+        }
+    }
+}
+
+static void visibility_avx2( uint64_t const* columns, int row_stride, uint64_t active_layers, FaceVisibility& out_visibility )
+{
+    __m256i active = _mm256_set1_epi64x( (long long) active_layers );
+    for ( int face = 0; face < BLOCK_FACE_COUNT; face++ )
+    {
+        BlockPosition normal = face_normal( face );
+        int neighbour_offset = normal.x + normal.z * row_stride;
+        for ( int z = 0; z < CHUNK_WIDTH; z++ )
+        {
+            uint64_t const* row = columns + z * row_stride;
+            uint64_t* out_row = out_visibility.faces[face] + z * CHUNK_WIDTH;
+            for ( int x = 0; x < CHUNK_WIDTH; x += 4 )
+            {
+                __m256i self = _mm256_loadu_si256( (__m256i const*) (row + x) );
+                __m256i covered;
+                if ( normal.y > 0 )
+                {
+                    covered = _mm256_srli_epi64( self, 1 );
+                }
+                else if ( normal.y < 0 )
+                {
+                    covered = _mm256_slli_epi64( self, 1 );
+                }
+                else
+                {
+                    covered = _mm256_loadu_si256( (__m256i const*) (row + x + neighbour_offset) );
+                }
+                __m256i visible = _mm256_and_si256( _mm256_andnot_si256( covered, self ), active );
+                _mm256_storeu_si256( (__m256i*) (out_row + x), visible );
+            }
+        }
+    }
+}
+
+void compute_visibility( uint64_t const* columns, int row_stride, uint64_t active_layers, VisibilityBackend backend, FaceVisibility& out_visibility )
+{
+    switch ( backend )
+    {
+    case VisibilityBackend::AVX2: visibility_avx2( columns, row_stride, active_layers, out_visibility ); break;
+    case VisibilityBackend::SSE2: visibility_sse2( columns, row_stride, active_layers, out_visibility ); break;
+    default: visibility_scalar( columns, row_stride, active_layers, out_visibility ); break;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "world/block.h"
+
+
+enum VisibilityBackend : uint8_t
+{
+    SCALAR = 0,
+    SSE2,
+    AVX2,
+};
+
+inline constexpr int VISIBILITY_BACKEND_COUNT = 3;
+
+struct FaceVisibility
+{
+    uint64_t faces[BLOCK_FACE_COUNT][CHUNK_WIDTH * CHUNK_WIDTH] = {};
+};
+
+bool visibility_supported( VisibilityBackend backend );
+VisibilityBackend visibility_backend();
+void set_visibility_backend( VisibilityBackend backend );
+
+void compute_visibility( uint64_t const* columns, int row_stride, uint64_t active_layers, VisibilityBackend backend, FaceVisibility& out_visibility );
@@ -1,8 +1,63 @@
 #include "world/world.h"
 
 
+static uint32_t occupied_sections( PaletteStorage const& blocks )
+{
+    uint32_t result = 0;
+    for ( int section = 0; section < PaletteStorage::SECTION_COUNT; section++ )
+    {
+        if ( blocks.section_kind( section ) != SectionKind::EMPTY )
+            result |= 1u << section;
+    }
+    return result;
+}
+
+static uint32_t border_sections( PaletteStorage const& blocks, PaletteStorage const& neighbour )
+{
+    uint32_t near = occupied_sections( neighbour );
+    near |= (near << 1) | (near >> 1);
+    return occupied_sections( blocks ) & near & Chunk::ALL_SECTIONS;
+}
+
+static flt3 snap_normal( flt3 const& normal )
+{
+    int axis = abs( normal.x ) > abs( normal.y ) && abs( normal.x ) > abs( normal.z ) ? 0 : (abs( normal.y ) > abs( normal.z ) ? 1 : 2);
+    flt3 result;
+    result[axis] = normal[axis] < 0.0f ? -1.0f : 1.0f;
+    return result;
+}
+
+static void mesh_blocks( ChunkPosition const& chunk_pos, Block const* blocks, std::vector<Quad>& out_quads, BlockTest const& block_test )
+{
+    std::mutex lock;
+    kl::async_for( 0, CHUNK_BLOCK_COUNT, [&]( int i )
+    {
+        Block block = blocks[i];
+        if ( is_block_gas( block ) )
+            return;
+
+        BlockPosition block_pos = BlockPosition::from_index( chunk_pos, BlockIndex::from_int( i ) );
+        std::vector<Quad> quads;
+        quads.reserve( 6 );
+        if ( is_block_pettle( block ) )
+        {
+            pettle_to_quads( block_pos, block, quads, block_test );
+        }
+        else
+        {
+            block_to_quads( block_pos, block, quads, block_test );
+        }
+
+        lock.lock();
+        out_quads.insert( out_quads.end(), quads.begin(), quads.end() );
+        lock.unlock();
+    } );
+}
+
 World::World( System& system, int render_distance )
     : system( system )
+    , streamer( generator, saver, system.gpu )
+    , cache( system.gpu )
 {
     set_render_distance( render_distance );
 }
@@ -14,6 +69,7 @@ int World::render_distance() const
 
 void World::set_render_distance( int render_distance )
 {
+    cache_resident();
     m_render_distance = render_distance;
     m_chunks.resize( chunk_count() );
     regenerate_all();
@@ -32,10 +88,50 @@ void World::set_world_center( flt3 world_center )
     if ( new_chunk_pos != old_chunk_pos )
     {
         ChunkIndex index_delta = (new_chunk_pos - old_chunk_pos).to_index();
-        regenerate_with_swap( index_delta );
+        update_focus();
+        stream_exposed( index_delta );
     }
 }
 
+flt3 World::view_direction() const
+{
+    return m_view_direction;
+}
+
+void World::set_view_direction( flt3 view_direction )
+{
+    m_view_direction = view_direction;
+    update_focus();
+}
+
+MeshMode World::mesh_mode() const
+{
+    return m_mesh_mode;
+}
+
+void World::set_mesh_mode( MeshMode mesh_mode )
+{
+    if ( mesh_mode == m_mesh_mode )
+        return;
+
+    m_mesh_mode = mesh_mode;
+    upload_all();
+}
+
+VertexFormat World::vertex_format() const
+{
+    return m_vertex_format;
+}
+
+void World::set_vertex_format( VertexFormat vertex_format )
+{
+    if ( vertex_format == m_vertex_format )
+        return;
+
+    m_vertex_format = vertex_format;
+    upload_all();
+}
+
 int World::width_chunks() const
 {
     return m_render_distance * 2 + 1;
@@ -48,12 +144,23 @@ int World::chunk_count() const
 
 Chunk& World::get_chunk( int index )
 {
-    return m_chunks[index];
+    return get_chunk( ChunkIndex::from_int( index, width_chunks() ) );
 }
 
 Chunk& World::get_chunk( ChunkIndex chunk_ind )
 {
-    return get_chunk( chunk_ind.to_int( width_chunks() ) );
+    return m_chunks[ring_index( chunk_ind )];
+}
+
+bool World::chunk_ready( ChunkIndex chunk_ind )
+{
+    return chunk_ind.is_valid( width_chunks() ) && get_chunk( chunk_ind ).stream_ticket == 0;
+}
+
+ChunkPosition World::chunk_position( int index ) const
+{
+    ChunkIndex chunk_ind = ChunkIndex::from_int( index, width_chunks() );
+    return first_chunk_pos() + ChunkPosition::from_index( chunk_ind );
 }
 
 BlockPosition World::get_block_world( ChunkIndex chunk_ind, BlockIndex block_ind ) const
@@ -61,12 +168,12 @@ BlockPosition World::get_block_world( ChunkIndex chunk_ind, BlockIndex block_ind
     return BlockPosition::from_flt3( first_chunk_pos().to_flt3() ) + BlockPosition::from_index( ChunkPosition::from_index( chunk_ind ), block_ind );
 }
 
-Block* World::get_world_block( BlockPosition const& block_pos )
+std::optional<Block> World::get_world_block( BlockPosition const& block_pos )
 {
     ChunkPosition chunk_pos = ChunkPosition::from_flt3( block_pos.to_flt3() );
     ChunkIndex chunk_ind = (chunk_pos - first_chunk_pos()).to_index();
     if ( !chunk_ind.is_valid( width_chunks() ) )
-        return nullptr;
+        return std::nullopt;
 
     auto& chunk = get_chunk( chunk_ind );
     BlockIndex block_ind = block_pos.to_index( chunk_pos );
@@ -94,43 +201,112 @@ ChunkPosition World::first_chunk_pos() const
     return ChunkPosition::from_flt3( m_world_center - render_dist_blocks );
 }
 
-void World::upload_save( int index )
+void World::edit_block( ChunkIndex chunk_ind, BlockIndex const& block_ind, Block block )
 {
-    ChunkIndex chunk_ind = ChunkIndex::from_int( index, width_chunks() );
+    if ( !block_ind.is_valid() )
+        return;
+
+    uint64_t start_time = kl::time::now();
     ChunkPosition chunk_pos = first_chunk_pos() + ChunkPosition::from_index( chunk_ind );
-    Chunk& chunk = get_chunk( index );
-    chunk.upload( chunk_pos, system.gpu, get_block_test() );
-    generator.save_chunk( chunk_pos, chunk );
+    Chunk& chunk = get_chunk( chunk_ind );
+    chunk.place_block( block_ind, block );
+    saver.record_edit( chunk_pos, block_ind, block, chunk.blocks );
+    upload_tracing( chunk_ind );
+    remesh_around( chunk_ind, block_ind );
+
+    float latency = kl::time::elapsed( start_time );
+    m_edit_stats.edits += 1;
+    m_edit_stats.last_latency = latency;
+    m_edit_stats.max_latency = std::max( m_edit_stats.max_latency, latency );
+    m_edit_total += latency;
 }
 
-void World::upload_save( ChunkIndex chunk_ind )
+EditStats World::edit_stats() const
 {
-    upload_save( chunk_ind.to_int( width_chunks() ) );
+    EditStats stats = m_edit_stats;
+    if ( stats.edits > 0 )
+        stats.average_latency = float( m_edit_total / stats.edits );
+    return stats;
 }
 
-void World::upload_tracing()
+void World::integrate_streamed()
 {
-    std::vector<Block> blocks;
-    blocks.reserve( std::size( m_chunks.front().blocks ) * m_chunks.size() );
-    for ( auto& chunk : m_chunks )
+    uint64_t start_time = kl::time::now();
+    StreamResult result;
+    while ( kl::time::elapsed( start_time ) < streamer.frame_budget && streamer.pop_result( result ) )
     {
-        blocks.insert( blocks.end(), chunk.blocks, chunk.blocks + std::size( chunk.blocks ) );
+        ChunkPosition chunk_pos = result.request.chunk_pos;
+        ChunkIndex chunk_ind = (chunk_pos - first_chunk_pos()).to_index();
+        if ( !chunk_ind.is_valid( width_chunks() ) || get_chunk( chunk_ind ).stream_ticket != result.request.ticket )
+        {
+            streamer.finish( false );
+            continue;
+        }
+
+        Chunk& chunk = get_chunk( chunk_ind );
+        chunk = std::move( result.chunk );
+        chunk.resident_pos = chunk_pos;
+        cache.erase( chunk_pos );
+        mark_borders( chunk_ind );
+        if ( result.request.mesh_mode != m_mesh_mode || result.request.vertex_format != m_vertex_format )
+        {
+            chunk.upload( chunk_pos, m_mesh_mode, m_vertex_format, system.gpu, make_snapshot( chunk_ind ) );
+            chunk.border_sections = 0;
+        }
+        upload_tracing( chunk_ind );
+
+        streamer.finish( true );
     }
+    remesh_borders();
+
+    if ( m_reload_start && chunk_ready( ChunkIndex{ m_render_distance, m_render_distance } ) )
+    {
+        m_first_playable_time = kl::time::elapsed( m_reload_start );
+        m_reload_start = 0;
+    }
+}
+
+float World::first_playable_time() const
+{
+    return m_first_playable_time;
+}
+
+void World::upload_tracing()
+{
+    std::vector<Block> blocks( (size_t) CHUNK_BLOCK_COUNT * m_chunks.size() );
+    kl::async_for( 0, (int) m_chunks.size(), [&]( int i )
+    {
+        m_chunks[i].blocks.extract( blocks.data() + (size_t) i * CHUNK_BLOCK_COUNT );
+    } );
 
     dx::BufferDescriptor descriptor{};
     descriptor.ByteWidth = (UINT) blocks.size();
-    descriptor.Usage = D3D11_USAGE_IMMUTABLE;
+    descriptor.Usage = D3D11_USAGE_DEFAULT;
     descriptor.BindFlags = D3D11_BIND_SHADER_RESOURCE;
     dx::SubresourceDescriptor subresource_data{};
     subresource_data.pSysMem = blocks.data();
-    dx::Buffer buffer = system.gpu.create_buffer( &descriptor, &subresource_data );
+    m_tracing_buffer = system.gpu.create_buffer( &descriptor, &subresource_data );
 
     dx::ShaderViewDescriptor view_descriptor{};
     view_descriptor.Format = DXGI_FORMAT_R8_UINT;
     view_descriptor.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
     view_descriptor.Buffer.FirstElement = 0;
     view_descriptor.Buffer.NumElements = (UINT) blocks.size();
-    m_tracing_view = system.gpu.create_shader_view( buffer, &view_descriptor );
+    m_tracing_view = system.gpu.create_shader_view( m_tracing_buffer, &view_descriptor );
+}
+
+void World::upload_tracing( ChunkIndex chunk_ind )
+{
+    if ( !m_tracing_buffer )
+    {
+        upload_tracing();
+        return;
+    }
+
+    std::vector<Block> blocks( CHUNK_BLOCK_COUNT );
+    get_chunk( chunk_ind ).blocks.extract( blocks.data() );
+    UINT byte_offset = UINT( ring_index( chunk_ind ) ) * CHUNK_BLOCK_COUNT;
+    system.gpu.update_buffer( m_tracing_buffer, blocks.data(), byte_offset, CHUNK_BLOCK_COUNT );
 }
 
 dx::ShaderView World::get_tracing_view() const
@@ -139,6 +315,123 @@ dx::ShaderView World::get_tracing_view() const
 }
 
 std::optional<HitPayload> World::cast_ray( ray const& ray, float reach )
+{
+    HitPayload payload{};
+    float distance = 0.0f;
+    if ( !trace_ray( ray, reach, payload, distance ) )
+        return std::nullopt;
+    return payload;
+}
+
+void World::cast_rays( std::span<ray const> rays, float reach, RayHits& out_hits )
+{
+    static constexpr int task_size = 256;
+
+    int ray_count = (int) rays.size();
+    out_hits.resize( ray_count );
+    if ( ray_count == 0 )
+        return;
+
+    int width = width_chunks();
+    int bin_count = chunk_count() + 1;
+    std::vector<int> bins( ray_count );
+    std::vector<int> offsets( bin_count + 1 );
+    for ( int i = 0; i < ray_count; i++ )
+    {
+        ChunkIndex chunk_ind = (ChunkPosition::from_flt3( rays[i].origin ) - first_chunk_pos()).to_index();
+        bins[i] = chunk_ind.is_valid( width ) ? chunk_ind.to_int( width ) : chunk_count();
+        offsets[bins[i] + 1] += 1;
+    }
+    for ( int i = 0; i < bin_count; i++ )
+        offsets[i + 1] += offsets[i];
+
+    std::vector<int> order( ray_count );
+    for ( int i = 0; i < ray_count; i++ )
+        order[offsets[bins[i]]++] = i;
+
+    int task_count = (ray_count + task_size - 1) / task_size;
+    kl::async_for( 0, task_count, [&]( int task )
+    {
+        int last = std::min( (task + 1) * task_size, ray_count );
+        for ( int i = task * task_size; i < last; i++ )
+        {
+            int ray_ind = order[i];
+            HitPayload payload{};
+            float distance = 0.0f;
+            bool hit = trace_ray( rays[ray_ind], reach, payload, distance );
+            out_hits.hits[ray_ind] = hit;
+            out_hits.chunk_inds[ray_ind] = payload.chunk_ind;
+            out_hits.block_inds[ray_ind] = payload.block_ind;
+            out_hits.normals[ray_ind] = payload.normal;
+            out_hits.distances[ray_ind] = hit ? distance : reach;
+        }
+    } );
+}
+
+bool World::trace_ray( ray const& ray, float reach, HitPayload& out_payload, float& out_distance )
+{
+    flt3 origin = ray.origin;
+    flt3 direction = ray.direction();
+    BlockPosition block_pos = BlockPosition::from_flt3( origin );
+
+    int step[3] = {};
+    float t_max[3] = {};
+    float t_delta[3] = {};
+    for ( int i = 0; i < 3; i++ )
+    {
+        int cell = i == 0 ? block_pos.x : (i == 1 ? block_pos.y : block_pos.z);
+        if ( direction[i] > 0.0f )
+        {
+            step[i] = 1;
+            t_max[i] = (cell + 1 - origin[i]) / direction[i];
+            t_delta[i] = 1.0f / direction[i];
+        }
+        else if ( direction[i] < 0.0f )
+        {
+            step[i] = -1;
+            t_max[i] = (cell - origin[i]) / direction[i];
+            t_delta[i] = -1.0f / direction[i];
+        }
+        else
+        {
+            t_max[i] = std::numeric_limits<float>::infinity();
+            t_delta[i] = std::numeric_limits<float>::infinity();
+        }
+    }
+
+    flt3 normal = snap_normal( origin - (block_pos.to_flt3() + flt3{ 0.5f }) );
+
+    float t_entry = 0.0f;
+    while ( t_entry < reach )
+    {
+        std::optional<Block> block = get_world_block( block_pos );
+        if ( block && !is_block_gas( *block ) )
+        {
+            ChunkPosition chunk_pos = ChunkPosition::from_flt3( block_pos.to_flt3() );
+            out_payload.chunk_ind = (chunk_pos - first_chunk_pos()).to_index();
+            out_payload.block_ind = block_pos.to_index( chunk_pos );
+            out_payload.normal = normal;
+            out_distance = t_entry;
+            return true;
+        }
+
+        int axis = t_max[0] < t_max[1] ? (t_max[0] < t_max[2] ? 0 : 2) : (t_max[1] < t_max[2] ? 1 : 2);
+        t_entry = t_max[axis];
+        t_max[axis] += t_delta[axis];
+        if ( axis == 0 )
+            block_pos.x += step[0];
+        else if ( axis == 1 )
+            block_pos.y += step[1];
+        else
+            block_pos.z += step[2];
+
+        normal = {};
+        normal[axis] = float( -step[axis] );
+    }
+    return false;
+}
+
+std::optional<HitPayload> World::cast_ray_brute_force( ray const& ray, float reach )
 {
     struct HitChunk
     {
@@ -165,32 +458,63 @@ std::optional<HitPayload> World::cast_ray( ray const& ray, float reach )
 
     float min_hit_dist = reach;
     std::optional<HitPayload> result;
+    BlockSnapshot snapshot;
+    std::vector<Block> blocks( PaletteSection::BLOCK_COUNT );
     for ( auto& hit_chunk : hit_chunks )
     {
-        for ( int i = 0; i < (int) std::size( hit_chunk.chunk.blocks ); i++ )
+        bool snapshot_ready = false;
+        auto section_buried = [&]( int section )
         {
-            BlockIndex block_ind = BlockIndex::from_int( i );
-            Block const& block = *hit_chunk.chunk.get_block( block_ind );
-            if ( is_block_gas( block ) )
-                continue;
+            if ( !snapshot_ready )
+            {
+                snapshot.build( hit_chunk.chunk.blocks, get_neighbours( hit_chunk.chunk_ind ) );
+                snapshot_ready = true;
+            }
+            return hit_chunk.chunk.section_buried( section, snapshot );
+        };
+        for ( int section = 0; section < PaletteStorage::SECTION_COUNT; section++ )
+        {
+            aabb section_box;
+            section_box.size = flt3{ CHUNK_HALF.x, PaletteSection::HEIGHT * 0.5f, CHUNK_HALF.z };
+            section_box.position = hit_chunk.chunk_pos.to_flt3() + flt3{ 0.0f, float( section * PaletteSection::HEIGHT ), 0.0f } + section_box.size;
 
-            aabb box;
-            box.size = flt3{ 0.5f };
-            box.position = hit_chunk.chunk_pos.to_flt3() + block_ind.to_flt3() + box.size;
+            bool skip = hit_chunk.chunk.blocks.section_kind( section ) == SectionKind::EMPTY
+                || !ray.intersect_aabb( section_box, nullptr )
+                || (!section_box.contains( ray.origin ) && section_buried( section ));
+            if ( skip )
+            {
+                m_trace_skipped_sections += 1;
+                continue;
+            }
+            m_traced_sections += 1;
 
-            flt3 inters;
-            if ( ray.intersect_aabb( box, &inters ) )
+            hit_chunk.chunk.blocks.sections[section].extract( blocks.data() );
+            int first_index = section * PaletteSection::BLOCK_COUNT;
+            for ( int i = 0; i < PaletteSection::BLOCK_COUNT; i++ )
             {
-                float hit_distance = (inters - ray.origin).length();
-                if ( hit_distance < min_hit_dist )
+                BlockIndex block_ind = BlockIndex::from_int( first_index + i );
+                Block block = blocks[i];
+                if ( is_block_gas( block ) )
+                    continue;
+
+                aabb box;
+                box.size = flt3{ 0.5f };
+                box.position = hit_chunk.chunk_pos.to_flt3() + block_ind.to_flt3() + box.size;
+
+                flt3 inters;
+                if ( ray.intersect_aabb( box, &inters ) )
                 {
-                    min_hit_dist = hit_distance;
+                    float hit_distance = (inters - ray.origin).length();
+                    if ( hit_distance < min_hit_dist )
+                    {
+                        min_hit_dist = hit_distance;
 
-                    HitPayload payload{};
-                    payload.chunk_ind = hit_chunk.chunk_ind;
-                    payload.block_ind = block_ind;
-                    payload.normal = kl::normalize( inters - box.position );
-                    result = payload;
+                        HitPayload payload{};
+                        payload.chunk_ind = hit_chunk.chunk_ind;
+                        payload.block_ind = block_ind;
+                        payload.normal = kl::normalize( inters - box.position );
+                        result = payload;
+                    }
                 }
             }
         }
@@ -224,6 +548,29 @@ void World::adjust_by_normal( HitPayload& payload ) const
     payload.block_ind = block_pos.to_index( chunk_pos );
 }
 
+bool World::collision_solid( BlockPosition const& block_pos )
+{
+    if ( block_pos.y < 0 )
+        return true;
+
+    ChunkPosition chunk_pos = ChunkPosition::from_flt3( block_pos.to_flt3() );
+    ChunkIndex chunk_ind = (chunk_pos - first_chunk_pos()).to_index();
+    if ( !chunk_ready( chunk_ind ) )
+        return true;
+
+    std::optional<Block> block = get_chunk( chunk_ind ).get_block( block_pos.to_index( chunk_pos ) );
+    return block && is_block_solid( *block );
+}
+
+void World::move_bodies( std::span<CollisionBody> bodies, float delta_t )
+{
+    BlockTest block_test = [this]( BlockPosition const& block_pos )
+    {
+        return collision_solid( block_pos );
+    };
+    ::move_bodies( bodies, delta_t, block_test );
+}
+
 bool World::chunk_visible( plane const& plane, int i ) const
 {
     ChunkIndex chunk_ind = ChunkIndex::from_int( i, width_chunks() );
@@ -247,52 +594,543 @@ bool World::chunk_visible( plane const& plane, int i ) const
     return false;
 }
 
-void World::regenerate_all()
+size_t World::block_bytes() const
+{
+    size_t result = 0;
+    for ( auto& chunk : m_chunks )
+        result += chunk.blocks.byte_size();
+    return result;
+}
+
+SectionStats World::section_stats() const
+{
+    SectionStats stats;
+    for ( auto& chunk : m_chunks )
+    {
+        for ( int i = 0; i < PaletteStorage::SECTION_COUNT; i++ )
+        {
+            switch ( chunk.blocks.section_kind( i ) )
+            {
+            case SectionKind::EMPTY: stats.empty_sections += 1; break;
+            case SectionKind::SOLID: stats.solid_sections += 1; break;
+            default: stats.mixed_sections += 1; break;
+            }
+        }
+        stats.resident_sections += PaletteStorage::SECTION_COUNT;
+        stats.mesh_skipped_sections += chunk.skipped_sections;
+    }
+    stats.generated_sections = generator.generated_sections;
+    stats.generate_skipped_sections = generator.skipped_sections;
+    stats.traced_sections = m_traced_sections;
+    stats.trace_skipped_sections = m_trace_skipped_sections;
+    return stats;
+}
+
+CodecBenchmark World::benchmark_codec( float edit_ratio, int repeats )
+{
+    static constexpr Block edit_blocks[] = { Block::AIR, Block::GRASS, Block::DIRT, Block::STONE, Block::COBBLE, Block::WOOD, Block::PLANKS };
+
+    std::vector<Block> blocks( (size_t) CHUNK_BLOCK_COUNT * m_chunks.size() );
+    kl::async_for( 0, (int) m_chunks.size(), [&]( int i )
+    {
+        m_chunks[i].blocks.extract( blocks.data() + (size_t) i * CHUNK_BLOCK_COUNT );
+    } );
+
+    int edit_count = int( blocks.size() * edit_ratio );
+    for ( int i = 0; i < edit_count; i++ )
+    {
+        int index = kl::random::gen_int( (int) blocks.size() );
+        blocks[index] = edit_blocks[kl::random::gen_int( (int) std::size( edit_blocks ) )];
+    }
+    return ::benchmark_codec( blocks, repeats );
+}
+
+MeshBenchmark World::benchmark_meshing( int repeats )
 {
-    auto get_chunk_pos = [this]( int i )
+    BlockTest block_test = [this]( BlockPosition const& block_pos ) -> bool
+    {
+        std::optional<Block> block = get_world_block( block_pos );
+        return block && is_block_solid( *block );
+    };
+
+    MeshBenchmark bench;
+    double test_total = 0.0;
+    double snapshot_total = 0.0;
+    double mode_total = 0.0;
+    std::vector<Block> blocks( CHUNK_BLOCK_COUNT );
+    std::vector<Quad> quads;
+    BlockSnapshot snapshot;
+    Chunk chunk;
+    for ( int i = 0; i < chunk_count(); i++ )
     {
         ChunkIndex chunk_ind = ChunkIndex::from_int( i, width_chunks() );
-        return first_chunk_pos() + ChunkPosition::from_index( chunk_ind );
+        if ( !chunk_ready( chunk_ind ) )
+            continue;
+
+        ChunkPosition chunk_pos = chunk_position( i );
+        chunk.blocks = get_chunk( i ).blocks;
+        chunk.blocks.extract( blocks.data() );
+        for ( int r = 0; r < repeats; r++ )
+        {
+            uint64_t start_time = kl::time::now();
+            quads.clear();
+            mesh_blocks( chunk_pos, blocks.data(), quads, block_test );
+            test_total += kl::time::elapsed( start_time );
+
+            start_time = kl::time::now();
+            snapshot.build( chunk.blocks, get_neighbours( chunk_ind ) );
+            chunk.convert( chunk_pos, MeshMode::PER_FACE, Chunk::ALL_SECTIONS, snapshot );
+            snapshot_total += kl::time::elapsed( start_time );
+
+            start_time = kl::time::now();
+            snapshot.build( chunk.blocks, get_neighbours( chunk_ind ) );
+            chunk.convert( chunk_pos, m_mesh_mode, Chunk::ALL_SECTIONS, snapshot );
+            mode_total += kl::time::elapsed( start_time );
+        }
+
+        chunk.convert( chunk_pos, MeshMode::PER_FACE, Chunk::ALL_SECTIONS, snapshot );
+        size_t snapshot_quads = 0;
+        for ( auto& section_quads : chunk.section_quads )
+            snapshot_quads += section_quads.size();
+        if ( snapshot_quads != quads.size() )
+            bench.mismatches += 1;
+        bench.chunk_count += 1;
+    }
+
+    int mesh_count = bench.chunk_count * repeats;
+    if ( mesh_count > 0 )
+    {
+        bench.test_time = float( test_total / mesh_count );
+        bench.snapshot_time = float( snapshot_total / mesh_count );
+        bench.mode_time = float( mode_total / mesh_count );
+    }
+    return bench;
+}
+
+RayBenchmark World::benchmark_ray_cast( int ray_count, float reach )
+{
+    RayBenchmark bench;
+    bench.ray_count = ray_count;
+    if ( ray_count <= 0 )
+        return bench;
+
+    std::vector<ray> rays( ray_count );
+    for ( auto& test_ray : rays )
+    {
+        flt3 origin = m_world_center + flt3{ kl::random::gen_float( -8.0f, 8.0f ), 0.0f, kl::random::gen_float( -8.0f, 8.0f ) };
+        origin.y = kl::random::gen_float( 0.0f, float( CHUNK_HEIGHT ) );
+        test_ray = { origin, flt3{ kl::random::gen_float( -1.0f, 1.0f ), kl::random::gen_float( -1.0f, 1.0f ), kl::random::gen_float( -1.0f, 1.0f ) } };
+    }
+
+    std::vector<std::optional<HitPayload>> dda_hits( ray_count );
+    uint64_t start_time = kl::time::now();
+    for ( int i = 0; i < ray_count; i++ )
+        dda_hits[i] = cast_ray( rays[i], reach );
+    bench.dda_time = kl::time::elapsed( start_time ) / ray_count;
+
+    std::vector<std::optional<HitPayload>> brute_hits( ray_count );
+    start_time = kl::time::now();
+    for ( int i = 0; i < ray_count; i++ )
+        brute_hits[i] = cast_ray_brute_force( rays[i], reach );
+    bench.brute_force_time = kl::time::elapsed( start_time ) / ray_count;
+
+    for ( int i = 0; i < ray_count; i++ )
+    {
+        auto& dda_hit = dda_hits[i];
+        auto& brute_hit = brute_hits[i];
+        if ( dda_hit )
+            bench.hits += 1;
+
+        bool same = dda_hit.has_value() == brute_hit.has_value();
+        if ( same && dda_hit )
+        {
+            HitPayload dda_adjusted = *dda_hit;
+            HitPayload brute_adjusted = *brute_hit;
+            adjust_by_normal( dda_adjusted );
+            adjust_by_normal( brute_adjusted );
+            same = dda_hit->chunk_ind == brute_hit->chunk_ind && dda_hit->block_ind == brute_hit->block_ind
+                && dda_adjusted.chunk_ind == brute_adjusted.chunk_ind && dda_adjusted.block_ind == brute_adjusted.block_ind;
+        }
+        if ( !same )
+            bench.mismatches += 1;
+    }
+    return bench;
+}
+
+RayCheck World::check_ray_cast()
+{
+    struct Feature
+    {
+        BlockPosition min;
+        BlockPosition max;
+        Block block;
     };
-    kl::async_for( 0, chunk_count(), [&]( int i )
+    static constexpr Feature features[] = {
+        { { 15, 32, 20 }, { 16, 39, 20 }, Block::STONE },
+        { { 30, 32, 31 }, { 34, 35, 32 }, Block::COBBLE },
+        { { 24, 10, 24 }, { 24, 31, 24 }, Block::AIR },
+        { { 5, 45, 5 }, { 12, 45, 12 }, Block::PLANKS },
+        { { 40, 32, 8 }, { 40, 32, 8 }, Block::ROSE },
+    };
+    static constexpr float reach = 64.0f;
+
+    std::vector<Chunk> old_chunks = std::move( m_chunks );
+    int old_render_distance = m_render_distance;
+    flt3 old_world_center = m_world_center;
+    uint64_t old_traced_sections = m_traced_sections;
+    uint64_t old_trace_skipped_sections = m_trace_skipped_sections;
+
+    m_render_distance = 1;
+    m_world_center = { 24.0f, 0.0f, 24.0f };
+    m_chunks = std::vector<Chunk>( chunk_count() );
+    std::vector<Block> blocks( CHUNK_BLOCK_COUNT );
+    for ( int i = 0; i < chunk_count(); i++ )
     {
-        generator.generate_chunk_cached( get_chunk_pos( i ), get_chunk( i ) );
-    } );
-    kl::async_for( 0, chunk_count(), [&]( int i )
+        ChunkPosition chunk_pos = chunk_position( i );
+        generate_synthetic( SyntheticTerrain::FLAT, blocks.data() );
+        for ( auto& feature : features )
+        {
+            for ( int j = 0; j < CHUNK_BLOCK_COUNT; j++ )
+            {
+                BlockPosition block_pos = BlockPosition::from_index( chunk_pos, BlockIndex::from_int( j ) );
+                bool inside = block_pos.x >= feature.min.x && block_pos.x <= feature.max.x
+                    && block_pos.y >= feature.min.y && block_pos.y <= feature.max.y
+                    && block_pos.z >= feature.min.z && block_pos.z <= feature.max.z;
+                if ( inside )
+                    blocks[j] = feature.block;
+            }
+        }
+        get_chunk( i ).blocks.assign( blocks.data() );
+    }
+
+    std::vector<ray> rays;
+    for ( int x : { 2, 8, 15, 16, 24, 31, 32, 40 } )
     {
-        get_chunk( i ).upload( get_chunk_pos( i ), system.gpu, get_block_test() );
-    } );
+        for ( int z : { 5, 20, 24, 32 } )
+            rays.emplace_back( flt3{ x + 0.5f, 60.5f, z + 0.5f }, flt3{ 0.0f, -1.0f, 0.0f } );
+    }
+    rays.emplace_back( flt3{ 2.5f, 33.5f, 20.5f }, flt3{ 1.0f, 0.0f, 0.0f } );
+    rays.emplace_back( flt3{ 30.5f, 33.5f, 20.5f }, flt3{ -1.0f, 0.0f, 0.0f } );
+    rays.emplace_back( flt3{ 32.5f, 34.5f, 10.5f }, flt3{ 0.0f, 0.0f, 1.0f } );
+    rays.emplace_back( flt3{ 32.5f, 34.5f, 46.5f }, flt3{ 0.0f, 0.0f, -1.0f } );
+    rays.emplace_back( flt3{ 24.5f, 12.5f, 24.5f }, flt3{ 0.0f, 1.0f, 0.0f } );
+    rays.emplace_back( flt3{ 8.5f, 40.5f, 8.5f }, flt3{ 0.0f, 1.0f, 0.0f } );
+
+    rays.emplace_back( flt3{ 5.5f, 20.8f, 5.5f }, flt3{ 0.3f, 1.0f, -0.2f } );
+    rays.emplace_back( flt3{ 16.2f, 33.5f, 20.5f }, flt3{ -1.0f, 0.1f, 0.0f } );
+    rays.emplace_back( flt3{ 31.5f, 34.5f, 32.9f }, flt3{ 0.0f, -0.4f, 1.0f } );
+    rays.emplace_back( flt3{ 47.5f, 0.1f, 47.5f }, flt3{ -1.0f, 0.2f, -0.5f } );
+
+    rays.emplace_back( flt3{ 14.3f, 40.7f, 3.6f }, flt3{ 1.0f, -0.6f, 0.9f } );
+    rays.emplace_back( flt3{ 33.2f, 36.4f, 46.1f }, flt3{ -1.2f, -0.3f, -1.0f } );
+    rays.emplace_back( flt3{ 47.3f, 33.4f, 47.6f }, flt3{ -1.0f, -0.05f, -1.1f } );
+    rays.emplace_back( flt3{ 1.3f, 50.2f, 30.7f }, flt3{ 1.0f, -1.0f, 0.2f } );
+    for ( int i = 0; i < 64; i++ )
+    {
+        float angle = i * (kl::pi() * 2.0f / 64.0f) + 0.01f;
+        flt3 offset{ cos( angle ), 0.0f, sin( angle ) };
+        flt3 origin = m_world_center + offset * 22.0f;
+        origin.y = 34.3f + (i % 5);
+        rays.emplace_back( origin, flt3{ -offset.x, -0.13f - 0.01f * (i % 7), -offset.z } );
+    }
+
+    RayCheck check;
+    check.ray_count = (int) rays.size();
+    for ( auto& test_ray : rays )
+    {
+        std::optional<HitPayload> dda_hit = cast_ray( test_ray, reach );
+        std::optional<HitPayload> brute_hit = cast_ray_brute_force( test_ray, reach );
+        if ( dda_hit )
+            check.hits += 1;
+
+        if ( dda_hit.has_value() != brute_hit.has_value() )
+        {
+            check.position_mismatches += 1;
+            continue;
+        }
+        if ( !dda_hit )
+            continue;
+
+        if ( get_block_world( dda_hit->chunk_ind, dda_hit->block_ind ) != get_block_world( brute_hit->chunk_ind, brute_hit->block_ind ) )
+            check.position_mismatches += 1;
+        if ( dda_hit->normal != snap_normal( brute_hit->normal ) )
+            check.normal_mismatches += 1;
+    }
+
+    m_chunks = std::move( old_chunks );
+    m_render_distance = old_render_distance;
+    m_world_center = old_world_center;
+    m_traced_sections = old_traced_sections;
+    m_trace_skipped_sections = old_trace_skipped_sections;
+    return check;
+}
+
+RayBatchBenchmark World::benchmark_ray_batch( int batch_size, int repeats, float reach )
+{
+    RayBatchBenchmark bench;
+    bench.batch_size = batch_size;
+    if ( batch_size <= 0 || repeats <= 0 )
+        return bench;
+
+    std::vector<ray> rays( batch_size );
+    for ( auto& test_ray : rays )
+    {
+        flt3 origin = m_world_center + flt3{ kl::random::gen_float( -24.0f, 24.0f ), 0.0f, kl::random::gen_float( -24.0f, 24.0f ) };
+        origin.y = kl::random::gen_float( 0.0f, float( CHUNK_HEIGHT ) );
+        test_ray = { origin, flt3{ kl::random::gen_float( -1.0f, 1.0f ), kl::random::gen_float( -1.0f, 1.0f ), kl::random::gen_float( -1.0f, 1.0f ) } };
+    }
+
+    RayHits hits;
+    uint64_t start_time = kl::time::now();
+    for ( int r = 0; r < repeats; r++ )
+        cast_rays( rays, reach, hits );
+    bench.batch_rate = batch_size * repeats / std::max( kl::time::elapsed( start_time ), 1e-6f );
+
+    start_time = kl::time::now();
+    for ( int r = 0; r < repeats; r++ )
+    {
+        for ( auto& test_ray : rays )
+            cast_ray( test_ray, reach );
+    }
+    bench.single_rate = batch_size * repeats / std::max( kl::time::elapsed( start_time ), 1e-6f );
+
+    for ( int i = 0; i < batch_size; i++ )
+    {
+        std::optional<HitPayload> hit = cast_ray( rays[i], reach );
+        bool same = hit.has_value() == bool( hits.hits[i] );
+        if ( same && hit )
+            same = hit->chunk_ind == hits.chunk_inds[i] && hit->block_ind == hits.block_inds[i];
+        if ( !same )
+            bench.mismatches += 1;
+    }
+    return bench;
+}
+
+void World::regenerate_all()
+{
+    cache_resident();
+    streamer.clear();
+    update_focus();
+    for ( int i = 0; i < chunk_count(); i++ )
+        stream_chunk( ChunkIndex::from_int( i, width_chunks() ) );
     upload_tracing();
 }
 
-void World::regenerate_with_swap( ChunkIndex index_delta )
+void World::cache_resident()
+{
+    for ( auto& chunk : m_chunks )
+    {
+        if ( chunk.resident_pos && chunk.stream_ticket == 0 )
+            cache.insert( *chunk.resident_pos, std::move( chunk ), m_mesh_mode, m_vertex_format );
+        chunk.resident_pos = std::nullopt;
+    }
+}
+
+void World::upload_all()
 {
-    m_copy_chunks = m_chunks;
     kl::async_for( 0, chunk_count(), [&]( int i )
     {
-        ChunkIndex chunk_ind = ChunkIndex::from_int( i, width_chunks() );
-        ChunkIndex src_chunk_ind = chunk_ind + index_delta;
-        if ( src_chunk_ind.is_valid( width_chunks() ) )
+        get_chunk( i ).upload( chunk_position( i ), m_mesh_mode, m_vertex_format, system.gpu, make_snapshot( ChunkIndex::from_int( i, width_chunks() ) ) );
+    } );
+}
+
+void World::stream_exposed( ChunkIndex index_delta )
+{
+    int width = width_chunks();
+    auto exposed_range = [width]( int delta, int& first, int& last )
+    {
+        first = delta > 0 ? std::max( width - delta, 0 ) : 0;
+        last = delta < 0 ? std::min( -delta, width ) : (delta > 0 ? width : 0);
+    };
+
+    int first_x = 0, last_x = 0;
+    int first_z = 0, last_z = 0;
+    exposed_range( index_delta.x, first_x, last_x );
+    exposed_range( index_delta.z, first_z, last_z );
+
+    std::vector<ChunkIndex> exposed;
+    for ( int z = 0; z < width; z++ )
+    {
+        if ( z >= first_z && z < last_z )
         {
-            int src_i = src_chunk_ind.to_int( width_chunks() );
-            m_chunks[i] = m_copy_chunks[src_i];
+            for ( int x = 0; x < width; x++ )
+                exposed.emplace_back( x, z );
         }
         else
         {
-            ChunkPosition chunk_pos = first_chunk_pos() + ChunkPosition::from_index( chunk_ind );
-            auto& chunk = get_chunk( i );
-            generator.generate_chunk_cached( chunk_pos, chunk );
-            chunk.upload( chunk_pos, system.gpu, get_block_test() );
+            for ( int x = first_x; x < last_x; x++ )
+                exposed.emplace_back( x, z );
         }
-    } );
-    upload_tracing();
+    }
+
+    auto mark_trailing = [this]( ChunkIndex chunk_ind )
+    {
+        if ( chunk_ready( chunk_ind ) )
+            get_chunk( chunk_ind ).border_sections |= occupied_sections( get_chunk( chunk_ind ).blocks );
+    };
+    for ( int i = 0; i < width; i++ )
+    {
+        if ( index_delta.x != 0 )
+            mark_trailing( ChunkIndex{ index_delta.x > 0 ? 0 : width - 1, i } );
+        if ( index_delta.z != 0 )
+            mark_trailing( ChunkIndex{ i, index_delta.z > 0 ? 0 : width - 1 } );
+    }
+
+    for ( auto& chunk_ind : exposed )
+    {
+        stream_chunk( chunk_ind );
+        upload_tracing( chunk_ind );
+    }
 }
 
-BlockTest World::get_block_test()
+void World::stream_chunk( ChunkIndex chunk_ind )
 {
-    return [this]( BlockPosition const& block_pos ) -> bool
+    Chunk& chunk = get_chunk( chunk_ind );
+    ChunkPosition chunk_pos = first_chunk_pos() + ChunkPosition::from_index( chunk_ind );
+    if ( chunk_ind == ChunkIndex{ m_render_distance, m_render_distance } && !m_reload_start )
+        m_reload_start = kl::time::now();
+
+    if ( chunk.resident_pos && chunk.stream_ticket == 0 )
+        cache.insert( *chunk.resident_pos, std::move( chunk ), m_mesh_mode, m_vertex_format );
+
+    for ( auto& quads : chunk.section_quads )
+        quads.clear();
+    chunk.quads_mode = std::nullopt;
+    chunk.border_sections = 0;
+
+    CachedChunk cached;
+    if ( cache.take( chunk_pos, cached ) )
     {
-        Block* block = get_world_block( block_pos );
-        return block && is_block_solid( *block );
-    };
+        chunk.blocks = std::move( cached.blocks );
+        chunk.buffer = std::move( cached.buffer );
+        chunk.quads_mode = cached.quads_mode;
+        for ( int i = 0; i < PaletteStorage::SECTION_COUNT; i++ )
+        {
+            chunk.section_quads[i] = std::move( cached.section_quads[i] );
+            chunk.section_slots[i] = cached.section_slots[i];
+        }
+        chunk.stream_ticket = 0;
+        chunk.resident_pos = chunk_pos;
+        mark_borders( chunk_ind );
+        if ( !cached.has_mesh || cached.mesh_mode != m_mesh_mode || cached.vertex_format != m_vertex_format )
+        {
+            chunk.upload( chunk_pos, m_mesh_mode, m_vertex_format, system.gpu, make_snapshot( chunk_ind ) );
+            chunk.border_sections = 0;
+        }
+        return;
+    }
+
+    chunk.blocks.fill( Block::AIR );
+    chunk.buffer = {};
+    chunk.resident_pos = std::nullopt;
+    chunk.stream_ticket = streamer.submit( chunk_pos, m_mesh_mode, m_vertex_format );
+}
+
+void World::mark_borders( ChunkIndex chunk_ind )
+{
+    Chunk& chunk = get_chunk( chunk_ind );
+    for ( int dz = -1; dz <= 1; dz++ )
+    {
+        for ( int dx = -1; dx <= 1; dx++ )
+        {
+            ChunkIndex neighbour_ind = chunk_ind + ChunkIndex{ dx, dz };
+            if ( neighbour_ind == chunk_ind || !chunk_ready( neighbour_ind ) )
+                continue;
+
+            Chunk& neighbour = get_chunk( neighbour_ind );
+            chunk.border_sections |= border_sections( chunk.blocks, neighbour.blocks );
+            neighbour.border_sections |= border_sections( neighbour.blocks, chunk.blocks );
+        }
+    }
+}
+
+void World::remesh_borders()
+{
+    uint64_t start_time = kl::time::now();
+    for ( int i = 0; i < chunk_count() && kl::time::elapsed( start_time ) < streamer.frame_budget; i++ )
+    {
+        ChunkIndex chunk_ind = ChunkIndex::from_int( i, width_chunks() );
+        Chunk& chunk = get_chunk( chunk_ind );
+        if ( !chunk.border_sections || chunk.stream_ticket != 0 )
+            continue;
+
+        chunk.upload( chunk_position( i ), m_mesh_mode, m_vertex_format, system.gpu, make_snapshot( chunk_ind ), chunk.border_sections );
+        chunk.border_sections = 0;
+    }
+}
+
+void World::remesh_around( ChunkIndex chunk_ind, BlockIndex const& block_ind )
+{
+    static constexpr int reach = BlockMasks::BORDER;
+
+    int first_section = std::max( block_ind.y - reach, 0 ) / PaletteSection::HEIGHT;
+    int last_section = std::min( block_ind.y + reach, CHUNK_HEIGHT - 1 ) / PaletteSection::HEIGHT;
+    uint32_t section_mask = 0;
+    for ( int section = first_section; section <= last_section; section++ )
+        section_mask |= 1u << section;
+
+    for ( int dz = -1; dz <= 1; dz++ )
+    {
+        if ( (dz < 0 && block_ind.z >= reach) || (dz > 0 && block_ind.z < CHUNK_WIDTH - reach) )
+            continue;
+
+        for ( int dx = -1; dx <= 1; dx++ )
+        {
+            if ( (dx < 0 && block_ind.x >= reach) || (dx > 0 && block_ind.x < CHUNK_WIDTH - reach) )
+                continue;
+
+            ChunkIndex neighbour_ind = chunk_ind + ChunkIndex{ dx, dz };
+            ChunkPosition chunk_pos = first_chunk_pos() + ChunkPosition::from_index( neighbour_ind );
+            if ( !chunk_ready( neighbour_ind ) )
+            {
+                cache.drop_mesh( chunk_pos );
+                continue;
+            }
+
+            get_chunk( neighbour_ind ).upload( chunk_pos, m_mesh_mode, m_vertex_format, system.gpu, make_snapshot( neighbour_ind ), section_mask );
+            m_edit_stats.remeshed_chunks += 1;
+            m_edit_stats.remeshed_sections += std::popcount( section_mask );
+        }
+    }
+}
+
+void World::update_focus()
+{
+    StreamFocus focus;
+    focus.first_chunk_pos = first_chunk_pos();
+    focus.width_chunks = width_chunks();
+    focus.center = m_world_center;
+    focus.forward = m_view_direction;
+    streamer.set_focus( focus );
+}
+
+int World::ring_index( ChunkIndex chunk_ind ) const
+{
+    int width = width_chunks();
+    ChunkIndex ring_ind = first_chunk_pos().to_index() + chunk_ind;
+    ring_ind.x = ((ring_ind.x % width) + width) % width;
+    ring_ind.z = ((ring_ind.z % width) + width) % width;
+    return ring_ind.to_int( width );
+}
+
+ChunkNeighbours World::get_neighbours( ChunkIndex chunk_ind )
+{
+    ChunkNeighbours neighbours{};
+    for ( int dz = -1; dz <= 1; dz++ )
+    {
+        for ( int dx = -1; dx <= 1; dx++ )
+        {
+            ChunkIndex neighbour_ind = chunk_ind + ChunkIndex{ dx, dz };
+            if ( neighbour_ind.is_valid( width_chunks() ) )
+                neighbours[(dx + 1) + (dz + 1) * 3] = &get_chunk( neighbour_ind ).blocks;
+        }
+    }
+    return neighbours;
+}
+
+BlockSnapshot World::make_snapshot( ChunkIndex chunk_ind )
+{
+    BlockSnapshot snapshot;
+    snapshot.build( get_chunk( chunk_ind ).blocks, get_neighbours( chunk_ind ) );
+    return snapshot;
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "system/system.h"
-#include "world/chunk.h"
+#include "world/streamer.h"
+#include "world/cache.h"
+#include "world/collision.h"
 
 
 struct HitPayload
@@ -11,10 +13,88 @@ struct HitPayload
     flt3 normal;
 };
 
+struct RayHits
+{
+    std::vector<byte> hits;
+    std::vector<ChunkIndex> chunk_inds;
+    std::vector<BlockIndex> block_inds;
+    std::vector<flt3> normals;
+    std::vector<float> distances;
+
+    void resize( int count )
+    {
+        hits.resize( count );
+        chunk_inds.resize( count );
+        block_inds.resize( count );
+        normals.resize( count );
+        distances.resize( count );
+    }
+};
+
+struct SectionStats
+{
+    int resident_sections = 0;
+    int empty_sections = 0;
+    int solid_sections = 0;
+    int mixed_sections = 0;
+    int mesh_skipped_sections = 0;
+    uint64_t generated_sections = 0;
+    uint64_t generate_skipped_sections = 0;
+    uint64_t traced_sections = 0;
+    uint64_t trace_skipped_sections = 0;
+};
+
+struct EditStats
+{
+    uint64_t edits = 0;
+    uint64_t remeshed_chunks = 0;
+    uint64_t remeshed_sections = 0;
+    float last_latency = 0.0f;
+    float average_latency = 0.0f;
+    float max_latency = 0.0f;
+};
+
+struct MeshBenchmark
+{
+    int chunk_count = 0;
+    int mismatches = 0;
+    float test_time = 0.0f;
+    float snapshot_time = 0.0f;
+    float mode_time = 0.0f;
+};
+
+struct RayBenchmark
+{
+    int ray_count = 0;
+    int hits = 0;
+    int mismatches = 0;
+    float dda_time = 0.0f;
+    float brute_force_time = 0.0f;
+};
+
+struct RayCheck
+{
+    int ray_count = 0;
+    int hits = 0;
+    int position_mismatches = 0;
+    int normal_mismatches = 0;
+};
+
+struct RayBatchBenchmark
+{
+    int batch_size = 0;
+    int mismatches = 0;
+    float batch_rate = 0.0f;
+    float single_rate = 0.0f;
+};
+
 struct World
 {
     System& system;
     ChunkGenerator generator{};
+    ChunkSaver saver{ generator };
+    ChunkStreamer streamer;
+    ChunkCache cache;
 
     World( System& system, int render_distance );
 
@@ -24,14 +104,25 @@ struct World
     flt3 world_center() const;
     void set_world_center( flt3 world_center );
 
+    flt3 view_direction() const;
+    void set_view_direction( flt3 view_direction );
+
+    MeshMode mesh_mode() const;
+    void set_mesh_mode( MeshMode mesh_mode );
+
+    VertexFormat vertex_format() const;
+    void set_vertex_format( VertexFormat vertex_format );
+
     int width_chunks() const;
     int chunk_count() const;
 
     Chunk& get_chunk( int index );
     Chunk& get_chunk( ChunkIndex chunk_ind );
+    bool chunk_ready( ChunkIndex chunk_ind );
 
+    ChunkPosition chunk_position( int index ) const;
     BlockPosition get_block_world( ChunkIndex chunk_ind, BlockIndex block_ind ) const;
-    Block* get_world_block( BlockPosition const& block_pos );
+    std::optional<Block> get_world_block( BlockPosition const& block_pos );
 
     Chunk& center_chunk();
     Chunk& first_chunk();
@@ -39,26 +130,61 @@ struct World
     ChunkPosition center_chunk_pos() const;
     ChunkPosition first_chunk_pos() const;
 
-    void upload_save( int index );
-    void upload_save( ChunkIndex chunk_ind );
+    void edit_block( ChunkIndex chunk_ind, BlockIndex const& block_ind, Block block );
+    EditStats edit_stats() const;
+
+    void integrate_streamed();
+    float first_playable_time() const;
 
     void upload_tracing();
     dx::ShaderView get_tracing_view() const;
 
     std::optional<HitPayload> cast_ray( ray const& ray, float reach = 5.0f );
+    void cast_rays( std::span<ray const> rays, float reach, RayHits& out_hits );
     void adjust_by_normal( HitPayload& payload ) const;
 
+    bool collision_solid( BlockPosition const& block_pos );
+    void move_bodies( std::span<CollisionBody> bodies, float delta_t );
+
     bool chunk_visible( plane const& plane, int i ) const;
+    size_t block_bytes() const;
+    SectionStats section_stats() const;
+    CodecBenchmark benchmark_codec( float edit_ratio, int repeats );
+    MeshBenchmark benchmark_meshing( int repeats );
+    RayBenchmark benchmark_ray_cast( int ray_count, float reach = 5.0f );
+    RayCheck check_ray_cast();
+    RayBatchBenchmark benchmark_ray_batch( int batch_size, int repeats, float reach = 16.0f );
 
 private:
     int m_render_distance;
     flt3 m_world_center;
+    flt3 m_view_direction = { 0.0f, 0.0f, 1.0f };
+    MeshMode m_mesh_mode = MeshMode::GREEDY;
+    VertexFormat m_vertex_format = VertexFormat::FULL;
     std::vector<Chunk> m_chunks;
-    std::vector<Chunk> m_copy_chunks;
+    dx::Buffer m_tracing_buffer;
     dx::ShaderView m_tracing_view;
+    uint64_t m_traced_sections = 0;
+    uint64_t m_trace_skipped_sections = 0;
+    uint64_t m_reload_start = 0;
+    float m_first_playable_time = 0.0f;
+    EditStats m_edit_stats;
+    double m_edit_total = 0.0;
 
     void regenerate_all();
-    void regenerate_with_swap( ChunkIndex index_delta );
-
-    BlockTest get_block_test();
+    void cache_resident();
+    void upload_all();
+    void stream_exposed( ChunkIndex index_delta );
+    void stream_chunk( ChunkIndex chunk_ind );
+    void mark_borders( ChunkIndex chunk_ind );
+    void remesh_borders();
+    void upload_tracing( ChunkIndex chunk_ind );
+    void remesh_around( ChunkIndex chunk_ind, BlockIndex const& block_ind );
+    bool trace_ray( ray const& ray, float reach, HitPayload& out_payload, float& out_distance );
+    std::optional<HitPayload> cast_ray_brute_force( ray const& ray, float reach );
+    void update_focus();
+    int ring_index( ChunkIndex chunk_ind ) const;
+
+    ChunkNeighbours get_neighbours( ChunkIndex chunk_ind );
+    BlockSnapshot make_snapshot( ChunkIndex chunk_ind );
 };